@@ -2,13 +2,17 @@
 
 #include "big_integer.h"
 #include "crypto_algorithms.h"
+#include "fixed_uint.h"
 
 
 namespace ElGamal {
 
+/// Coordinates are residues modulo the 112-bit prime of the curve
+using Element = FixedUInt<128>;
+
 struct Point {
-    BigInteger x;
-    BigInteger y;
+    Element x;
+    Element y;
     
     bool operator == (const Point& rhs) const;
     bool operator != (const Point& r) const;
@@ -19,8 +23,6 @@ struct Point {
     friend std::ostream& operator << (std::ostream& os, const Point& a);
 };
 
-static BigInteger parseHexadecimal(const std::string& hex);
-
 class Bob {
 private:
     BigInteger k;
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "big_integer.h"
+
+/// Repeated reductions modulo one number without long divisions.
+/// mu = [2 ^ (128 * k) / N] is computed once, where k is the number of limbs of N,
+/// after that x mod N costs two multiplications and at most two subtractions.
+class BarrettReducer {
+  public:
+    /// REQUIREMENT: Modulus has to be positive
+    explicit BarrettReducer(const BigInteger& modulus);
+
+    const BigInteger& GetModulus() const;
+
+    /// x mod N, the result is always in [0, N)
+    /// Numbers outside of [0, 2 ^ (128 * k)) fall back to the ordinary division
+    BigInteger reduce(const BigInteger& x) const;
+    /// The same, the result is computed in the storage of x
+    BigInteger reduce(BigInteger&& x) const;
+
+    BigInteger mulmod(const BigInteger& lhs, const BigInteger& rhs) const;
+    BigInteger sqrmod(const BigInteger& x) const;
+
+  private:
+    BigInteger modulus_;
+    size_t size_;
+    BigInteger mu_;
+};
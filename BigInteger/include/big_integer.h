@@ -1,12 +1,31 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <utility>
 
+#include "small_vector.h"
+
+/// Number of limbs stored inside of BigInteger without heap allocations
+#ifndef BIGINTEGER_INLINE_LIMBS
+#define BIGINTEGER_INLINE_LIMBS 4
+#endif
+
+/// Arbitrary precision signed integer.
+/// The magnitude is stored as little-endian base 2^64 limbs,
+/// decimal representation is built only on conversion to/from strings.
 class BigInteger {
   public:
     using Digit = unsigned char;
+    using Limb = uint64_t;
+    using Limbs = SmallVector<Limb, BIGINTEGER_INLINE_LIMBS>;
+
+    static constexpr int kLimbBits = 64;
 
     BigInteger() : BigInteger(0) {}
     BigInteger(const BigInteger& other);
@@ -14,17 +33,28 @@ class BigInteger {
     BigInteger(long long number);
     BigInteger(const std::string& number);
 
+    /// Decimal digit, counting from the most significant one
     /// 1 <= pos <= number_length
+    /// Numbers longer than a limb are converted to decimal on every call,
+    /// loops over the digits should convert once with ToString()
     Digit getDigitAt(int pos) const;
 
     static BigInteger zero();
-    const std::vector<Digit>& data() const;
+    const Limbs& data() const;
+    /// Number of decimal digits
     size_t getLength() const;
 
     bool IsPositive() const;
     bool IsEven() const;
     bool IsOdd() const;
 
+    /// Number of significant bits in the magnitude, 0 for zero
+    size_t bit_length() const;
+    /// Bit pos of the two's complement form, the same as ((*this >> pos) & 1) == 1
+    bool test_bit(size_t pos) const;
+    /// Number of zero bits below the lowest set one, the same for x and -x, 0 for zero
+    size_t count_trailing_zeros() const;
+
     int ToInt() const;
     long long ToLong() const;
     std::string ToString() const;
@@ -46,83 +76,398 @@ class BigInteger {
     BigInteger& operator = (const BigInteger& other);
     BigInteger& operator = (BigInteger&& other) noexcept;
 
-    BigInteger  operator + (long long other) const;
-    BigInteger  operator + (const BigInteger& other) const;
+    /// Overloads for temporaries compute the result in place and return their storage,
+    /// so chains like (a * b) % p + c allocate only where the result has to grow
+    BigInteger  operator + (long long other) const &;
+    BigInteger  operator + (long long other) &&;
+    BigInteger  operator + (const BigInteger& other) const &;
+    BigInteger  operator + (const BigInteger& other) &&;
+    BigInteger  operator + (BigInteger&& other) const &;
+    BigInteger  operator + (BigInteger&& other) &&;
     BigInteger& operator += (long long other);
     BigInteger& operator += (const BigInteger& other);
 
-    BigInteger  operator - (long long other) const;
-    BigInteger  operator - (BigInteger other) const;
+    BigInteger  operator - (long long other) const &;
+    BigInteger  operator - (long long other) &&;
+    BigInteger  operator - (const BigInteger& other) const &;
+    BigInteger  operator - (const BigInteger& other) &&;
+    BigInteger  operator - (BigInteger&& other) const &;
+    BigInteger  operator - (BigInteger&& other) &&;
     BigInteger& operator -= (long long other);
     BigInteger& operator -= (const BigInteger& other);
 
-    BigInteger  operator * (long long other) const;
+    BigInteger  operator * (long long other) const &;
+    BigInteger  operator * (long long other) &&;
     BigInteger  operator * (const BigInteger& other) const;
     BigInteger& operator *= (long long other);
     BigInteger& operator *= (const BigInteger& other);
 
-    BigInteger  operator / (long long other) const;
-    BigInteger  operator / (const BigInteger& other) const;
+    BigInteger  operator / (long long other) const &;
+    BigInteger  operator / (long long other) &&;
+    BigInteger  operator / (const BigInteger& other) const &;
+    BigInteger  operator / (const BigInteger& other) &&;
     BigInteger& operator /= (long long other);
     BigInteger& operator /= (const BigInteger& other);
 
     /// Remainder: works like remainder for integral types in C++
     /// [a / b] * b + a % b = a
-    BigInteger  operator % (long long other) const;
-    BigInteger  operator % (const BigInteger& other) const;
+    BigInteger  operator % (long long other) const &;
+    BigInteger  operator % (long long other) &&;
+    BigInteger  operator % (const BigInteger& other) const &;
+    BigInteger  operator % (const BigInteger& other) &&;
     BigInteger& operator %= (long long other);
     BigInteger& operator %= (const BigInteger& other);
 
+    /// Multiplication and division by 2^shift in one pass over the limbs,
+    /// the right shift of a negative number rounds down like for integral types
+    BigInteger  operator << (size_t shift) const &;
+    BigInteger  operator << (size_t shift) &&;
+    BigInteger& operator <<= (size_t shift);
+    BigInteger  operator >> (size_t shift) const &;
+    BigInteger  operator >> (size_t shift) &&;
+    BigInteger& operator >>= (size_t shift);
+
+    /// Bitwise operations on two's complement forms with infinite sign extension,
+    /// so -1 has all the bits set and x & (2^k - 1) is x mod 2^k
+    BigInteger  operator & (const BigInteger& other) const;
+    BigInteger  operator | (const BigInteger& other) const;
+    BigInteger  operator ^ (const BigInteger& other) const;
+    BigInteger& operator &= (const BigInteger& other);
+    BigInteger& operator |= (const BigInteger& other);
+    BigInteger& operator ^= (const BigInteger& other);
+
     static BigInteger pow(const BigInteger& number, const BigInteger& power);
     static BigInteger pow(const BigInteger& number, const BigInteger& power,
                          const BigInteger& md);
+    /// 2 ^ power, built directly from the limbs
+    static BigInteger pow2(size_t power);
+
+    /// numbers[0] ^ powers[0] * ... * numbers[k - 1] ^ powers[k - 1] mod md by Straus' method:
+    /// all terms share one chain of squarings, so the product costs about one exponentiation
+    /// REQUIREMENT: Powers can't be negative, there are as many of them as numbers
+    static BigInteger multi_pow(const std::vector<BigInteger>& numbers,
+                                const std::vector<BigInteger>& powers, const BigInteger& md);
+
+    /// number * number, every cross product is computed once
+    static BigInteger sqr(const BigInteger& number);
 
+    /// The same as isqrt
     static BigInteger sqrt(const BigInteger& number);
+    /// [sqrt(number)] by Newton's iteration with precision doubling
+    /// REQUIREMENT: Number can't be negative
+    static BigInteger isqrt(const BigInteger& number);
+    static bool is_perfect_square(const BigInteger& number);
 
     static BigInteger abs(BigInteger number);
 
     static BigInteger mod(const BigInteger& lhs, const BigInteger& rhs);
+    static BigInteger mod(BigInteger&& lhs, const BigInteger& rhs);
+
+    /// Quotient and remainder of one division, the same as [lhs / rhs] and lhs % rhs
+    static void divmod(const BigInteger& lhs, const BigInteger& rhs,
+                       BigInteger& quotient, BigInteger& remainder);
+    /// Division by a machine integer in one pass without allocations,
+    /// quotient may be the same object as LHS, returns lhs % rhs
+    static long long divmod_small(const BigInteger& lhs, long long rhs, BigInteger& quotient);
 
     static BigInteger gcd(BigInteger lhs, BigInteger rhs);
     static BigInteger lcm(const BigInteger& lhs, const BigInteger& rhs);
 
+    /// Extended Euclid: returns gcd(lhs, rhs) >= 0 and sets x, y, so that lhs * x + rhs * y = gcd
+    static BigInteger ext_gcd(const BigInteger& lhs, const BigInteger& rhs,
+                              BigInteger& x, BigInteger& y);
+    /// x in [0, modulus), such that number * x = 1 (mod modulus), nothing if there is no such x
+    /// REQUIREMENT: Modulus has to be positive
+    static std::optional<BigInteger> inverse_mod(const BigInteger& number, const BigInteger& modulus);
+    /// Inverses of all numbers by one inverse_mod and 3(n - 1) multiplications,
+    /// nothing if at least one of the numbers isn't invertible
+    /// REQUIREMENT: Modulus has to be positive
+    static std::optional<std::vector<BigInteger>> batch_inverse_mod(
+            const std::vector<BigInteger>& numbers, const BigInteger& modulus);
+
+    /// Sizes of the shorter operand in limbs where multiplication changes the algorithm:
+    /// schoolbook up to karatsuba limbs, then Karatsuba, Toom-3 from toom3 limbs
+    /// for balanced operands and number-theoretic transform from ntt limbs.
+    /// Karatsuba and Toom-3 subproducts of at least parallel limbs are forked
+    /// to TaskPool::Global() when it has workers.
+    struct MultiplicationThresholds {
+        size_t karatsuba = 32;
+        size_t toom3 = 2500;
+        size_t ntt = 25000;
+        size_t parallel = 384;
+    };
+    static MultiplicationThresholds GetMultiplicationThresholds();
+    /// Not synchronized, has to be called before other threads start multiplying
+    static void SetMultiplicationThresholds(const MultiplicationThresholds& thresholds);
+    /// Benchmarks neighbouring algorithms on random operands and returns the crossover points,
+    /// the result can be passed to SetMultiplicationThresholds.
+    /// Not synchronized: the thresholds are switched while it runs, so it has to be called
+    /// while no other thread multiplies
+    static MultiplicationThresholds TuneMultiplicationThresholds();
+
     static BigInteger GetFromBase2(const std::string& src);
     static BigInteger GetFromBase64(const std::string& src);
     static BigInteger GetFromByte(const std::string& src);
 
-protected:
-    struct DivisionResult {
-        std::vector<Digit> quotient;
-        std::vector<Digit> remainder;
+    enum class ByteOrder {
+        LittleEndian,
+        BigEndian
     };
 
+    /// Number of bytes of the magnitude, 0 for zero
+    size_t byte_length() const;
+    /// Magnitude as exactly size bytes padded with zeros, the sign is dropped
+    /// REQUIREMENT: size >= byte_length()
+    void export_bytes(uint8_t* out, size_t size, ByteOrder order) const;
+    /// Non-negative number with the magnitude [data, data + size)
+    static BigInteger import_bytes(const uint8_t* data, size_t size, ByteOrder order);
+
+    /// Length-prefixed binary form: a 4-byte header with the sign in the top bit
+    /// and the number of magnitude bytes in the rest, then the magnitude,
+    /// the header and the magnitude are both written in the given byte order
+    size_t serialized_size() const;
+    /// Writes serialized_size() bytes to out, returns their number
+    size_t write_to(uint8_t* out, ByteOrder order = ByteOrder::BigEndian) const;
+    /// Reads one number written by write_to from the beginning of [data, data + size),
+    /// read is set to the number of bytes it took, nothing if the input is truncated
+    static std::optional<BigInteger> read_from(const uint8_t* data, size_t size, size_t& read,
+                                               ByteOrder order = ByteOrder::BigEndian);
+
+protected:
+    friend class MontgomeryContext;
+    friend class BarrettReducer;
+    friend class FixedBasePow;
+    friend class RandomGenerator;
+    template <size_t> friend class FixedUInt;
+
+    using DoubleLimb = unsigned __int128;
+
     enum class CompareSign {
         LESS = -1,
         EQUAL = 0,
         GREATER = 1
     };
 
-    BigInteger(const std::vector<Digit>& number) : num_(number) { validate(); }
-    static BigInteger buildByDigitalVector(const std::vector<Digit>& number);
+    BigInteger(const Limbs& number) : num_(number) { validate(); }
+    BigInteger(Limbs&& number) : num_(std::move(number)) { validate(); }
 
-    static CompareSign compareUnsignedNumbers(const std::vector<Digit>& lhs,
-                                              const std::vector<Digit>& rhs);
-    static std::vector<Digit> getUnsignedSum(const std::vector<Digit>& lhs,
-                                             const std::vector<Digit>& rhs);
+    static CompareSign compareUnsignedNumbers(const Limbs& lhs,
+                                              const Limbs& rhs);
+    static Limbs getUnsignedSum(const Limbs& lhs, const Limbs& rhs);
     /// REQUIREMENT: LHS has to be not less than RHS
-    static std::vector<Digit> getUnsignedDiff(const std::vector<Digit>& lhs,
-                                              const std::vector<Digit>& rhs);
+    static Limbs getUnsignedDiff(const Limbs& lhs, const Limbs& rhs);
+    /// Knuth's algorithm D, writes into quotient and remainder reusing their storage,
+    /// both of them may alias LHS or RHS, a null one isn't computed
     /// REQUIREMENT: RHS can't be equal to zero
-    static DivisionResult getUnsignedDivision(BigInteger lhs,
-                                              BigInteger rhs);
+    static void getUnsignedDivision(const Limbs& lhs,
+                                    const Limbs& rhs,
+                                    Limbs* quotient,
+                                    Limbs* remainder);
+    /// Signed division with the signs of operator / and operator %,
+    /// quotient and remainder may be LHS or RHS, a null one isn't computed
+    static void divide(const BigInteger& lhs, const BigInteger& rhs,
+                       BigInteger* quotient, BigInteger* remainder);
     static BigInteger NativeMultiplication(const BigInteger& lhs, const BigInteger& rhs);
     static BigInteger KaratsubaMultiplication(const BigInteger& lhs, const BigInteger& rhs);
+    static BigInteger ToomCook3Multiplication(const BigInteger& lhs, const BigInteger& rhs);
+    static BigInteger NTTMultiplication(const BigInteger& lhs, const BigInteger& rhs);
+    /// Picks the multiplication algorithm by the thresholds
+    static BigInteger Multiplication(const BigInteger& lhs, const BigInteger& rhs);
+    /// Binary gcd for short numbers, the work is linear in bits per step
+    /// REQUIREMENT: both numbers are positive
+    static Limbs getBinaryGcd(Limbs lhs, Limbs rhs);
+    /// gcd(lhs, rhs) by iterative Lehmer-accelerated Euclid, x is the cofactor of LHS
+    static BigInteger getGcdCofactor(const BigInteger& lhs, const BigInteger& rhs, BigInteger& x);
+    /// Lehmer's gcd with single-word cofactors for long numbers
+    /// REQUIREMENT: both numbers are positive
+    static Limbs getLehmerGcd(Limbs lhs, Limbs rhs);
+    /// result[0, 2 * size) = number[0, size) ^ 2, by schoolbook or Karatsuba squaring
+    static void getUnsignedSquare(const Limb* number, size_t size, Limb* result);
+    /// Appends decimal digits of the magnitude padded with zeros up to width,
+    /// long numbers are split by the powers 10^(19 * 2^k) recursively
+    static void appendDecimal(const Limbs& number, size_t width, std::string& result);
+    /// Magnitude of the decimal digits [begin, end), the inverse of appendDecimal
+    static Limbs parseDecimal(const char* begin, const char* end);
+
+    /// this = this + (is_positive ? magnitude : -magnitude)
+    void addSmall(Limb magnitude, bool is_positive);
+    /// this = this + (is_positive ? magnitude : -magnitude) in the storage of this
+    /// REQUIREMENT: magnitude isn't num_ of this
+    void addSigned(const Limbs& magnitude, bool is_positive);
+
+    /// Window width for sliding window exponentiation by a power of given bit length
+    static size_t getWindowSize(size_t bit_length);
+
+    /// Left-to-right sliding window exponentiation, reads bits of power directly.
+    /// Multiply(lhs, rhs, result) and Square(x, result) write into a separate result,
+    /// so T can be any element type with a cheap in-place product (BigInteger, limb vector).
+    /// REQUIREMENT: Power can't be negative
+    template <class T, class Multiply, class Square>
+    static T slidingWindowPow(const T& number, const T& one, const BigInteger& power,
+                              Multiply multiply, Square square);
+
+    /// Interleaved sliding windows for a product of powers: every term has its own table
+    /// of odd powers and window, the squarings of the result are done once for all of them
+    /// REQUIREMENT: Powers can't be negative, there are as many of them as numbers
+    template <class T, class Multiply, class Square>
+    static T slidingWindowMultiPow(const std::vector<T>& numbers, const T& one,
+                                   const std::vector<BigInteger>& powers,
+                                   Multiply multiply, Square square);
+
+    /// The first size of from, from * 5/4, ... up to to where candidate_wins(size) holds at this
+    /// and the next measured size, so a single noisy sample doesn't count. A win at the last
+    /// size can't be confirmed, no confirmed win gives std::numeric_limits<size_t>::max()
+    template <class Wins>
+    static size_t findCrossover(size_t from, size_t to, Wins candidate_wins);
 
     void validateSign();
     void validate();
 
-    std::vector<Digit> num_;
+    Limbs num_;
     bool is_positive_{true};
 };
 
 std::ostream& operator << (std::ostream& fout, const BigInteger& number);
+
+template <class T, class Multiply, class Square>
+T BigInteger::slidingWindowPow(const T& number, const T& one, const BigInteger& power,
+                               Multiply multiply, Square square) {
+    const size_t bit_length = power.bit_length();
+    if (bit_length == 0) {
+        return one;
+    }
+    const size_t window = getWindowSize(bit_length);
+
+    /// table[i] = number ^ (2i + 1)
+    std::vector<T> table(size_t(1) << (window - 1), number);
+    if (table.size() > 1) {
+        T number_sqr = number;
+        square(number, number_sqr);
+        for (size_t i = 1; i < table.size(); ++i) {
+            multiply(table[i - 1], number_sqr, table[i]);
+        }
+    }
+
+    T result = one;
+    T tmp = one;
+    bool is_one = true;
+    for (size_t pos = bit_length; pos > 0; ) {
+        if (!power.test_bit(pos - 1)) {
+            if (!is_one) {
+                square(result, tmp);
+                std::swap(result, tmp);
+            }
+            --pos;
+            continue;
+        }
+
+        /// The longest window [low, pos) which fits and ends with a set bit
+        size_t low = (pos > window ? pos - window : 0);
+        while (!power.test_bit(low)) {
+            ++low;
+        }
+        size_t value = 0;
+        for (size_t i = pos; i > low; --i) {
+            value = (value << 1) | (power.test_bit(i - 1) ? 1 : 0);
+        }
+
+        if (is_one) {
+            result = table[value >> 1];
+            is_one = false;
+        } else {
+            for (size_t i = low; i < pos; ++i) {
+                square(result, tmp);
+                std::swap(result, tmp);
+            }
+            multiply(result, table[value >> 1], tmp);
+            std::swap(result, tmp);
+        }
+        pos = low;
+    }
+    return result;
+}
+
+template <class T, class Multiply, class Square>
+T BigInteger::slidingWindowMultiPow(const std::vector<T>& numbers, const T& one,
+                                    const std::vector<BigInteger>& powers,
+                                    Multiply multiply, Square square) {
+    const size_t count = numbers.size();
+    size_t bit_length = 0;
+    std::vector<size_t> windows(count, 0);
+    /// tables[k][i] = numbers[k] ^ (2i + 1)
+    std::vector<std::vector<T>> tables(count);
+    for (size_t k = 0; k < count; ++k) {
+        const size_t bits = powers[k].bit_length();
+        if (bits == 0) {
+            continue;
+        }
+        bit_length = (bits > bit_length ? bits : bit_length);
+        windows[k] = getWindowSize(bits);
+        tables[k].assign(size_t(1) << (windows[k] - 1), numbers[k]);
+        if (tables[k].size() > 1) {
+            T number_sqr = numbers[k];
+            square(numbers[k], number_sqr);
+            for (size_t i = 1; i < tables[k].size(); ++i) {
+                multiply(tables[k][i - 1], number_sqr, tables[k][i]);
+            }
+        }
+    }
+
+    /// An open window [low, pos) of a term is multiplied in when the squarings reach its low bit
+    std::vector<bool> is_open(count, false);
+    std::vector<size_t> window_low(count, 0);
+    std::vector<size_t> window_value(count, 0);
+    T result = one;
+    T tmp = one;
+    bool is_one = true;
+    for (size_t pos = bit_length; pos > 0; --pos) {
+        if (!is_one) {
+            square(result, tmp);
+            std::swap(result, tmp);
+        }
+        for (size_t k = 0; k < count; ++k) {
+            if (!is_open[k] && powers[k].test_bit(pos - 1)) {
+                /// The longest window [low, pos) which fits and ends with a set bit
+                size_t low = (pos > windows[k] ? pos - windows[k] : 0);
+                while (!powers[k].test_bit(low)) {
+                    ++low;
+                }
+                size_t value = 0;
+                for (size_t i = pos; i > low; --i) {
+                    value = (value << 1) | (powers[k].test_bit(i - 1) ? 1 : 0);
+                }
+                is_open[k] = true;
+                window_low[k] = low;
+                window_value[k] = value;
+            }
+            if (is_open[k] && window_low[k] == pos - 1) {
+                const T& factor = tables[k][window_value[k] >> 1];
+                if (is_one) {
+                    result = factor;
+                    is_one = false;
+                } else {
+                    multiply(result, factor, tmp);
+                    std::swap(result, tmp);
+                }
+                is_open[k] = false;
+            }
+        }
+    }
+    return result;
+}
+
+template <class Wins>
+size_t BigInteger::findCrossover(size_t from, size_t to, Wins candidate_wins) {
+    constexpr size_t kNever = std::numeric_limits<size_t>::max();
+    size_t first_win = kNever;
+    for (size_t size = from; size <= to; size += std::max<size_t>(size / 4, 1)) {
+        if (!candidate_wins(size)) {
+            first_win = kNever;
+        } else if (first_win == kNever) {
+            first_win = size;
+        } else {
+            return first_win;
+        }
+    }
+    return kNever;
+}
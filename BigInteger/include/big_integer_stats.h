@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// Optional counters of BigInteger operations, compiled in with -DBIGINTEGER_STATS.
+/// Every thread counts into its own counters without locks,
+/// a snapshot sums the counters of all threads, running and finished ones.
+/// With -DBIGINTEGER_STATS_PROFILE counted operations are easy_profiler blocks as well.
+namespace BigIntegerStats {
+    enum class Operation : size_t {
+        /// Every product of two numbers, whatever algorithm is chosen
+        Multiply,
+        Schoolbook,
+        Karatsuba,
+        ToomCook3,
+        NTT,
+        Square,
+        /// Long division, all of /, % and mod end here
+        Divide,
+        Pow,
+        Gcd,
+        /// Conversions to and from strings in any base
+        Convert,
+        Count
+    };
+
+    constexpr size_t kOperations = static_cast<size_t>(Operation::Count);
+
+    struct Counter {
+        uint64_t calls = 0;
+        /// Sum of the operand sizes in limbs
+        uint64_t limbs = 0;
+    };
+
+    struct Snapshot {
+        std::array<Counter, kOperations> operations{};
+        /// Heap buffers of limbs and blocks of the scratch arenas
+        uint64_t allocations = 0;
+        uint64_t allocated_bytes = 0;
+
+        const Counter& operator[](Operation operation) const {
+            return operations[static_cast<size_t>(operation)];
+        }
+    };
+
+    constexpr bool IsEnabled() {
+#ifdef BIGINTEGER_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    const char* GetName(Operation operation);
+
+    /// Sum over all threads, zeros if the counters aren't compiled in
+    Snapshot GetSnapshot();
+    /// Resets the counters of all threads, updates racing with it may be lost
+    void Reset();
+
+    void Count(Operation operation, size_t limbs);
+    void CountAllocation(size_t bytes);
+}  // namespace BigIntegerStats
+
+#ifdef BIGINTEGER_STATS
+#define BIGINTEGER_STATS_COUNT(operation, limbs) \
+    BigIntegerStats::Count(BigIntegerStats::Operation::operation, (limbs))
+#define BIGINTEGER_STATS_ALLOCATION(bytes) BigIntegerStats::CountAllocation(bytes)
+#else
+#define BIGINTEGER_STATS_COUNT(operation, limbs) ((void)0)
+#define BIGINTEGER_STATS_ALLOCATION(bytes) ((void)0)
+#endif
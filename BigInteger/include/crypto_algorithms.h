@@ -4,10 +4,18 @@
 
 
 namespace Crypto {
+    /// Reseeds the generator of the calling thread from std::random_device,
+    /// every thread draws from its own ChaCha20 stream (RandomGenerator::ForThread)
     void RandomSeedInitialization();
 
+    /// Uniform in [0, |max_value|]
     BigInteger GetRandomNumber(const BigInteger& max_value);
+    /// Uniform in [min_value, max_value]
+    /// REQUIREMENT: min_value <= max_value
     BigInteger GetRandomNumber(const BigInteger& min_value, const BigInteger& max_value);
+    /// count numbers uniform in [min_value, max_value], e.g. candidates of a prime search
+    std::vector<BigInteger> GetRandomNumbers(const BigInteger& min_value, const BigInteger& max_value,
+                                             size_t count);
     BigInteger GetRandomNumberLen(int len);
     BigInteger GetRandomNumberWithBitness(int bitness);
 
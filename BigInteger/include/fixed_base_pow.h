@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "barrett.h"
+#include "big_integer.h"
+#include "montgomery.h"
+
+/// Repeated exponentiation of one base modulo one number by the Lim-Lee comb.
+/// A power e of at most t * d bits is split into t rows of d bits, the table holds
+/// g ^ (v_0 + v_1 * 2^d + ... + v_{t-1} * 2^((t-1)d)) for every nonzero bit mask v,
+/// after that g ^ e costs d - 1 squarings and at most d multiplications.
+class FixedBasePow {
+  public:
+    static constexpr size_t kDefaultTeeth = 6;
+
+    /// Powers longer than max_power_bits fall back to BigInteger::pow,
+    /// by default the bit length of the modulus is used
+    /// REQUIREMENT: Modulus has to be positive, teeth in [1, 16]
+    FixedBasePow(const BigInteger& base, const BigInteger& modulus,
+                 size_t max_power_bits = 0, size_t teeth = kDefaultTeeth);
+
+    /// Shared table for (base, modulus), built on the first request.
+    /// Repeated key exchanges with the same generator reuse it, safe to call from several threads.
+    static std::shared_ptr<const FixedBasePow> Get(const BigInteger& base, const BigInteger& modulus);
+
+    const BigInteger& GetBase() const;
+    const BigInteger& GetModulus() const;
+
+    /// base ^ power mod modulus
+    /// REQUIREMENT: Power can't be negative
+    BigInteger pow(const BigInteger& power) const;
+
+  private:
+    BigInteger mul(const BigInteger& lhs, const BigInteger& rhs) const;
+    BigInteger sqr(const BigInteger& x) const;
+
+    BigInteger base_;
+    BigInteger modulus_;
+    size_t teeth_;
+    /// Bits per row
+    size_t rows_length_;
+    /// Odd moduli use Montgomery form, the rest Barrett reduction
+    std::unique_ptr<MontgomeryContext> montgomery_;
+    std::unique_ptr<BarrettReducer> barrett_;
+    /// table_[v] for v in [1, 2^teeth), table_[0] is one, in Montgomery form for odd moduli
+    std::vector<BigInteger> table_;
+};
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "big_integer.h"
+
+/// Unsigned integer of a width known at compile time, for curve coordinates,
+/// hash digests and other crypto-sized numbers. Limbs live on the stack, loops
+/// have constant trip counts, and everything except the conversions to/from
+/// BigInteger is constexpr, so constants can be parsed at compile time.
+/// Plain arithmetic wraps modulo 2^Bits like built-in unsigned types.
+template <size_t Bits>
+class FixedUInt {
+    static_assert(Bits > 0 && Bits % 64 == 0, "Width has to be a whole number of limbs");
+
+  public:
+    using Limb = uint64_t;
+    static constexpr size_t kLimbs = Bits / 64;
+
+    constexpr FixedUInt() = default;
+    constexpr FixedUInt(Limb value) : limbs_{value} {}
+
+    /// Big-endian hexadecimal digits without a prefix, both cases are accepted
+    /// REQUIREMENT: The value has to fit into Bits
+    static constexpr FixedUInt FromHex(std::string_view hex);
+    /// REQUIREMENT: 0 <= number < 2^Bits
+    static FixedUInt FromBigInteger(const BigInteger& number);
+    BigInteger ToBigInteger() const;
+    /// Exactly Bits binary digits, leading zeros included
+    std::string GetBase2() const;
+
+    constexpr Limb operator [] (size_t pos) const { return limbs_[pos]; }
+    constexpr Limb& operator [] (size_t pos) { return limbs_[pos]; }
+
+    constexpr bool operator == (const FixedUInt& other) const { return compare(other) == 0; }
+    constexpr bool operator != (const FixedUInt& other) const { return compare(other) != 0; }
+    constexpr bool operator <  (const FixedUInt& other) const { return compare(other) < 0; }
+    constexpr bool operator <= (const FixedUInt& other) const { return compare(other) <= 0; }
+    constexpr bool operator >  (const FixedUInt& other) const { return compare(other) > 0; }
+    constexpr bool operator >= (const FixedUInt& other) const { return compare(other) >= 0; }
+
+    /// this += other, returns the carry out of the top limb
+    constexpr Limb addWithCarry(const FixedUInt& other);
+    /// this -= other, returns the borrow out of the top limb
+    constexpr Limb subWithBorrow(const FixedUInt& other);
+
+    constexpr FixedUInt operator + (const FixedUInt& other) const;
+    constexpr FixedUInt operator - (const FixedUInt& other) const;
+    constexpr FixedUInt operator * (const FixedUInt& other) const;
+
+    /// The whole product without wrapping
+    template <size_t OtherBits>
+    constexpr FixedUInt<Bits + OtherBits> mul_full(const FixedUInt<OtherBits>& other) const;
+
+    /// number mod modulus by Knuth's algorithm D
+    /// REQUIREMENT: Modulus can't be equal to zero
+    template <size_t NumberBits>
+    static constexpr FixedUInt mod(const FixedUInt<NumberBits>& number, const FixedUInt& modulus);
+
+    /// REQUIREMENT: Both operands are less than modulus
+    static constexpr FixedUInt addmod(const FixedUInt& lhs, const FixedUInt& rhs, const FixedUInt& modulus);
+    static constexpr FixedUInt submod(const FixedUInt& lhs, const FixedUInt& rhs, const FixedUInt& modulus);
+    static constexpr FixedUInt mulmod(const FixedUInt& lhs, const FixedUInt& rhs, const FixedUInt& modulus);
+
+    /// Number of significant bits, 0 for zero
+    constexpr size_t bit_length() const;
+    constexpr bool test_bit(size_t pos) const { return (limbs_[pos / 64] >> (pos % 64)) & 1; }
+
+  private:
+    template <size_t> friend class FixedUInt;
+
+    using DoubleLimb = unsigned __int128;
+
+    /// Sign of this - other
+    constexpr int compare(const FixedUInt& other) const;
+
+    std::array<Limb, kLimbs> limbs_{};
+};
+
+template <size_t Bits>
+constexpr FixedUInt<Bits> FixedUInt<Bits>::FromHex(std::string_view hex) {
+    assert(hex.size() <= Bits / 4 || hex.find_first_not_of('0') >= hex.size() - Bits / 4);
+    FixedUInt result;
+    size_t pos = 0;
+    for (auto it = hex.rbegin(); it != hex.rend(); ++it, pos += 4) {
+        const char c = *it;
+        Limb digit = 0;
+        if ('0' <= c && c <= '9') {
+            digit = c - '0';
+        } else if ('a' <= c && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if ('A' <= c && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            assert(false);  // c isn't a hexadecimal digit
+        }
+        if (pos < Bits) {
+            result.limbs_[pos / 64] |= digit << (pos % 64);
+        }
+    }
+    return result;
+}
+
+template <size_t Bits>
+FixedUInt<Bits> FixedUInt<Bits>::FromBigInteger(const BigInteger& number) {
+    assert(number.IsPositive() && number.data().size() <= kLimbs);
+    FixedUInt result;
+    for (size_t i = 0; i < number.data().size(); ++i) {
+        result.limbs_[i] = number.data()[i];
+    }
+    return result;
+}
+
+template <size_t Bits>
+BigInteger FixedUInt<Bits>::ToBigInteger() const {
+    return BigInteger(BigInteger::Limbs(limbs_.begin(), limbs_.end()));
+}
+
+template <size_t Bits>
+std::string FixedUInt<Bits>::GetBase2() const {
+    std::string result(Bits, '0');
+    for (size_t pos = 0; pos < Bits; ++pos) {
+        if (test_bit(pos)) {
+            result[Bits - 1 - pos] = '1';
+        }
+    }
+    return result;
+}
+
+template <size_t Bits>
+constexpr int FixedUInt<Bits>::compare(const FixedUInt& other) const {
+    for (size_t i = kLimbs; i > 0; --i) {
+        if (limbs_[i - 1] != other.limbs_[i - 1]) {
+            return (limbs_[i - 1] < other.limbs_[i - 1] ? -1 : 1);
+        }
+    }
+    return 0;
+}
+
+template <size_t Bits>
+constexpr typename FixedUInt<Bits>::Limb FixedUInt<Bits>::addWithCarry(const FixedUInt& other) {
+    Limb carry = 0;
+    for (size_t i = 0; i < kLimbs; ++i) {
+        const DoubleLimb cur = (DoubleLimb)limbs_[i] + other.limbs_[i] + carry;
+        limbs_[i] = static_cast<Limb>(cur);
+        carry = static_cast<Limb>(cur >> 64);
+    }
+    return carry;
+}
+
+template <size_t Bits>
+constexpr typename FixedUInt<Bits>::Limb FixedUInt<Bits>::subWithBorrow(const FixedUInt& other) {
+    Limb borrow = 0;
+    for (size_t i = 0; i < kLimbs; ++i) {
+        const Limb sub = other.limbs_[i] + borrow;
+        borrow = (sub < borrow || limbs_[i] < sub) ? 1 : 0;
+        limbs_[i] -= sub;
+    }
+    return borrow;
+}
+
+template <size_t Bits>
+constexpr FixedUInt<Bits> FixedUInt<Bits>::operator + (const FixedUInt& other) const {
+    FixedUInt result = *this;
+    result.addWithCarry(other);
+    return result;
+}
+
+template <size_t Bits>
+constexpr FixedUInt<Bits> FixedUInt<Bits>::operator - (const FixedUInt& other) const {
+    FixedUInt result = *this;
+    result.subWithBorrow(other);
+    return result;
+}
+
+template <size_t Bits>
+constexpr FixedUInt<Bits> FixedUInt<Bits>::operator * (const FixedUInt& other) const {
+    FixedUInt result;
+    for (size_t i = 0; i < kLimbs; ++i) {
+        Limb carry = 0;
+        for (size_t j = 0; i + j < kLimbs; ++j) {
+            const DoubleLimb cur = (DoubleLimb)limbs_[i] * other.limbs_[j] + result.limbs_[i + j] + carry;
+            result.limbs_[i + j] = static_cast<Limb>(cur);
+            carry = static_cast<Limb>(cur >> 64);
+        }
+    }
+    return result;
+}
+
+template <size_t Bits>
+template <size_t OtherBits>
+constexpr FixedUInt<Bits + OtherBits> FixedUInt<Bits>::mul_full(const FixedUInt<OtherBits>& other) const {
+    FixedUInt<Bits + OtherBits> result;
+    for (size_t i = 0; i < kLimbs; ++i) {
+        Limb carry = 0;
+        for (size_t j = 0; j < FixedUInt<OtherBits>::kLimbs; ++j) {
+            const DoubleLimb cur = (DoubleLimb)limbs_[i] * other.limbs_[j] + result.limbs_[i + j] + carry;
+            result.limbs_[i + j] = static_cast<Limb>(cur);
+            carry = static_cast<Limb>(cur >> 64);
+        }
+        result.limbs_[i + FixedUInt<OtherBits>::kLimbs] = carry;
+    }
+    return result;
+}
+
+template <size_t Bits>
+template <size_t NumberBits>
+constexpr FixedUInt<Bits> FixedUInt<Bits>::mod(const FixedUInt<NumberBits>& number, const FixedUInt& modulus) {
+    constexpr size_t kNumberLimbs = FixedUInt<NumberBits>::kLimbs;
+    size_t n = kLimbs;
+    while (n > 0 && modulus.limbs_[n - 1] == 0) {
+        --n;
+    }
+    assert(n > 0);
+
+    FixedUInt result;
+    if (n == 1) {
+        DoubleLimb remainder = 0;
+        for (size_t i = kNumberLimbs; i > 0; --i) {
+            remainder = ((remainder << 64) | number.limbs_[i - 1]) % modulus.limbs_[0];
+        }
+        result.limbs_[0] = static_cast<Limb>(remainder);
+        return result;
+    }
+    if (kNumberLimbs < n) {
+        /// The number is shorter than the modulus
+        for (size_t i = 0; i < kNumberLimbs && i < kLimbs; ++i) {
+            result.limbs_[i] = number.limbs_[i];
+        }
+        return result;
+    }
+
+    /// Normalize, so the top bit of the divisor is set, then every quotient limb
+    /// estimated by two leading limbs is at most 2 greater than the real one
+    const int shift = __builtin_clzll(modulus.limbs_[n - 1]);
+    std::array<Limb, kLimbs> v{};
+    std::array<Limb, kNumberLimbs + 1> u{};
+    for (size_t i = n; i > 0; --i) {
+        v[i - 1] = (modulus.limbs_[i - 1] << shift) |
+                   (shift && i > 1 ? modulus.limbs_[i - 2] >> (64 - shift) : 0);
+    }
+    u[kNumberLimbs] = (shift ? number.limbs_[kNumberLimbs - 1] >> (64 - shift) : 0);
+    for (size_t i = kNumberLimbs; i > 0; --i) {
+        u[i - 1] = (number.limbs_[i - 1] << shift) |
+                   (shift && i > 1 ? number.limbs_[i - 2] >> (64 - shift) : 0);
+    }
+
+    for (size_t j = kNumberLimbs - n + 1; j > 0; --j) {
+        const size_t pos = j - 1;
+        const DoubleLimb numerator = ((DoubleLimb)u[pos + n] << 64) | u[pos + n - 1];
+        DoubleLimb q_hat = numerator / v[n - 1];
+        DoubleLimb r_hat = numerator % v[n - 1];
+        while ((q_hat >> 64) != 0 || q_hat * v[n - 2] > ((r_hat << 64) | u[pos + n - 2])) {
+            --q_hat;
+            r_hat += v[n - 1];
+            if ((r_hat >> 64) != 0) {
+                break;
+            }
+        }
+
+        Limb borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const DoubleLimb product = q_hat * v[i] + borrow;
+            const Limb low = static_cast<Limb>(product);
+            borrow = static_cast<Limb>(product >> 64) + (u[pos + i] < low ? 1 : 0);
+            u[pos + i] -= low;
+        }
+        const bool negative = (u[pos + n] < borrow);
+        u[pos + n] -= borrow;
+        if (negative) {
+            Limb carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const DoubleLimb sum = (DoubleLimb)u[pos + i] + v[i] + carry;
+                u[pos + i] = static_cast<Limb>(sum);
+                carry = static_cast<Limb>(sum >> 64);
+            }
+            u[pos + n] += carry;
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        result.limbs_[i] = (u[i] >> shift) | (shift ? u[i + 1] << (64 - shift) : 0);
+    }
+    return result;
+}
+
+template <size_t Bits>
+constexpr FixedUInt<Bits> FixedUInt<Bits>::addmod(const FixedUInt& lhs, const FixedUInt& rhs,
+                                                  const FixedUInt& modulus) {
+    FixedUInt result = lhs;
+    const Limb carry = result.addWithCarry(rhs);
+    if (carry != 0 || result >= modulus) {
+        result.subWithBorrow(modulus);
+    }
+    return result;
+}
+
+template <size_t Bits>
+constexpr FixedUInt<Bits> FixedUInt<Bits>::submod(const FixedUInt& lhs, const FixedUInt& rhs,
+                                                  const FixedUInt& modulus) {
+    FixedUInt result = lhs;
+    if (result.subWithBorrow(rhs) != 0) {
+        result.addWithCarry(modulus);
+    }
+    return result;
+}
+
+template <size_t Bits>
+constexpr FixedUInt<Bits> FixedUInt<Bits>::mulmod(const FixedUInt& lhs, const FixedUInt& rhs,
+                                                  const FixedUInt& modulus) {
+    return mod(lhs.mul_full(rhs), modulus);
+}
+
+template <size_t Bits>
+constexpr size_t FixedUInt<Bits>::bit_length() const {
+    for (size_t i = kLimbs; i > 0; --i) {
+        if (limbs_[i - 1] != 0) {
+            return (i - 1) * 64 + (64 - __builtin_clzll(limbs_[i - 1]));
+        }
+    }
+    return 0;
+}
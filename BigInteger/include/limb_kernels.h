@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Carry-propagating loops over limb vectors, the innermost work of addition,
+/// schoolbook multiplication, division and Montgomery reduction.
+/// Every kernel has a portable version and versions for x86-64 instruction set
+/// extensions, the fastest one supported by the CPU is picked once at runtime.
+namespace LimbKernels {
+    struct Table {
+        /// Name of the implementation, for benchmarks and logs
+        const char* name;
+        /// result[0, n) = a[0, n) + b[0, n), returns the carry
+        uint64_t (*add)(uint64_t* result, const uint64_t* a, const uint64_t* b, size_t n);
+        /// result[0, n) = a[0, n) - b[0, n), returns the borrow
+        uint64_t (*sub)(uint64_t* result, const uint64_t* a, const uint64_t* b, size_t n);
+        /// result[0, n) += a[0, n) * b, returns the limb carried out
+        uint64_t (*addmul)(uint64_t* result, const uint64_t* a, size_t n, uint64_t b);
+        /// result[0, n) -= a[0, n) * b, returns the limb borrowed from above
+        uint64_t (*submul)(uint64_t* result, const uint64_t* a, size_t n, uint64_t b);
+    };
+
+    /// Plain C++ with 128-bit intermediate values
+    const Table& Portable();
+    /// Chosen by CPUID: add-with-carry chains on x86-64, MULX and ADX when they are available
+    const Table& Native();
+
+    /// Result may alias either operand
+    inline uint64_t Add(uint64_t* result, const uint64_t* a, const uint64_t* b, size_t n) {
+        return Native().add(result, a, b, n);
+    }
+
+    /// Result may alias either operand
+    inline uint64_t Sub(uint64_t* result, const uint64_t* a, const uint64_t* b, size_t n) {
+        return Native().sub(result, a, b, n);
+    }
+
+    /// REQUIREMENT: result and a don't overlap
+    inline uint64_t AddMul(uint64_t* result, const uint64_t* a, size_t n, uint64_t b) {
+        return Native().addmul(result, a, n, b);
+    }
+
+    /// REQUIREMENT: result and a don't overlap
+    inline uint64_t SubMul(uint64_t* result, const uint64_t* a, size_t n, uint64_t b) {
+        return Native().submul(result, a, n, b);
+    }
+}  // namespace LimbKernels
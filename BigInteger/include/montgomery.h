@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include "big_integer.h"
+
+/// Arithmetic modulo a fixed odd number without long divisions.
+/// Numbers are kept in Montgomery form x * R mod N, where R = 2 ^ (64 * limbs(N)),
+/// so a product is reduced with multiplications and shifts only (REDC).
+class MontgomeryContext {
+  public:
+    using Limb = BigInteger::Limb;
+    using Limbs = BigInteger::Limbs;
+
+    /// REQUIREMENT: Modulus has to be odd and greater than one
+    explicit MontgomeryContext(const BigInteger& modulus);
+
+    const BigInteger& GetModulus() const;
+
+    /// x -> x * R mod N, x can be any integer
+    BigInteger ToMontgomery(const BigInteger& x) const;
+    /// x * R mod N -> x
+    BigInteger FromMontgomery(const BigInteger& x) const;
+
+    /// Montgomery form of 1
+    const BigInteger& one() const;
+
+    /// Both arguments and the result are in Montgomery form
+    BigInteger mul(const BigInteger& lhs, const BigInteger& rhs) const;
+    BigInteger sqr(const BigInteger& x) const;
+
+    /// number ^ power mod N, arguments and the result are in the ordinary form
+    /// REQUIREMENT: Power can't be negative
+    BigInteger pow(const BigInteger& number, const BigInteger& power) const;
+    /// The same power left in Montgomery form, for callers that keep working with mul and sqr
+    /// REQUIREMENT: Power can't be negative
+    BigInteger pow_montgomery(const BigInteger& number, const BigInteger& power) const;
+    /// numbers[0] ^ powers[0] * ... * numbers[k - 1] ^ powers[k - 1] mod N with shared squarings
+    /// REQUIREMENT: Powers can't be negative, there are as many of them as numbers
+    BigInteger multi_pow(const std::vector<BigInteger>& numbers,
+                         const std::vector<BigInteger>& powers) const;
+
+  private:
+    /// result = lhs * rhs * R^(-1) mod N
+    /// lhs, rhs and result have size_ limbs, scratch has size_ + 2 limbs
+    void multiply(const Limb* lhs, const Limb* rhs, Limb* result, Limb* scratch) const;
+    /// result = x * x * R^(-1) mod N, scratch has 2 * size_ + 1 limbs
+    void square(const Limb* x, Limb* result, Limb* scratch) const;
+    /// result = t mod N for t < 2N of size_ + 1 limbs
+    void normalize(const Limb* t, Limb* result) const;
+
+    /// number ^ power in Montgomery form of size_ limbs
+    Limbs powLimbs(const BigInteger& number, const BigInteger& power, Limbs& scratch) const;
+    Limbs expand(const BigInteger& x) const;
+    /// x in Montgomery form of size_ limbs -> x in the ordinary form
+    BigInteger leave(const Limbs& x, Limb* scratch) const;
+    static BigInteger build(Limbs limbs);
+
+    BigInteger modulus_;
+    Limbs n_;
+    size_t size_;
+    /// -N^(-1) mod 2^64
+    Limb n_prime_;
+    BigInteger r_;
+    BigInteger r2_;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NTT {
+    /// result[0, na + nb) = a[0, na) * b[0, nb) by number-theoretic transforms
+    /// modulo three 62-bit primes, combined with the Chinese remainder theorem.
+    /// Every limb is one coefficient, so operands up to 2^50 limbs are supported.
+    void Multiply(const uint64_t* a, size_t na, const uint64_t* b, size_t nb, uint64_t* result);
+}  // namespace NTT
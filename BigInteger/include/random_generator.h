@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "big_integer.h"
+
+/// Random limbs from the ChaCha20 keystream, numbers are filled limb by limb
+/// without decimal digits. A generator isn't synchronized, every thread draws
+/// from its own one (ForThread), so prime searches can run in parallel.
+class RandomGenerator {
+  public:
+    using Limb = BigInteger::Limb;
+
+    /// Key from std::random_device
+    RandomGenerator();
+    /// Reproducible stream, the key is expanded from seed by SplitMix64
+    explicit RandomGenerator(uint64_t seed);
+
+    Limb Next();
+    void Fill(Limb* out, size_t count);
+
+    /// Uniform in [0, |max_value|] by rejection: magnitudes of the bit length of max_value
+    /// are drawn until one isn't greater than it, less than two draws on average
+    BigInteger GetNumber(const BigInteger& max_value);
+    /// Uniform in [min_value, max_value]
+    /// REQUIREMENT: min_value <= max_value
+    BigInteger GetNumber(const BigInteger& min_value, const BigInteger& max_value);
+    /// Uniform among the numbers of exactly bitness bits, one fill with the top bit set
+    /// REQUIREMENT: bitness >= 1
+    BigInteger GetNumberWithBitness(size_t bitness);
+
+    /// count independent draws, the bound is prepared once for all of them
+    std::vector<BigInteger> GetNumbers(const BigInteger& min_value, const BigInteger& max_value,
+                                       size_t count);
+    std::vector<BigInteger> GetNumbersWithBitness(size_t bitness, size_t count);
+
+    /// Generator of the calling thread, seeded from std::random_device on the first use
+    static RandomGenerator& ForThread();
+
+  private:
+    static constexpr size_t kBlockLimbs = 8;
+
+    explicit RandomGenerator(const std::array<uint32_t, 8>& key);
+
+    /// Next 64-byte block of the keystream
+    void generateBlock(Limb* out);
+    /// Uniform in [0, bound] into number, reusing its storage
+    void drawUpTo(const BigInteger& bound, BigInteger::Limbs& number);
+
+    std::array<uint32_t, 16> state_;
+    std::array<Limb, kBlockLimbs> buffer_;
+    size_t buffered_ = 0;
+};
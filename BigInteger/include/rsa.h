@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <optional>
+
 #include "big_integer.h"
+#include "montgomery.h"
 
 namespace RSA {
 
@@ -30,6 +33,10 @@ class Bob {
     BigInteger phi_;
     BigInteger e_;
     BigInteger d_;
+
+    /// Private exponents reduced for CRT decoding
+    BigInteger dp_, dq_;
+    std::optional<MontgomeryContext> p_context_, q_context_;
 };
 
 class Alice {
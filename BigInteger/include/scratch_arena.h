@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// Thread-local bump allocator for temporaries of the arithmetic kernels.
+/// Memory is handed out from a few large blocks and given back all at once
+/// when the outermost Scope ends, so repeated operations of the same size
+/// don't touch the heap after the first one.
+class ScratchArena {
+  public:
+    using Limb = uint64_t;
+
+    struct Stats {
+        /// Number of allocate() calls
+        size_t allocations = 0;
+        /// Number of blocks requested from the heap
+        size_t heap_allocations = 0;
+        /// Maximal number of limbs used at once
+        size_t peak_usage = 0;
+    };
+
+    /// Everything allocated inside of a scope is released at its end
+    class Scope {
+      public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator = (const Scope&) = delete;
+
+        ScratchArena& arena() const { return arena_; }
+
+      private:
+        ScratchArena& arena_;
+        size_t block_;
+        size_t offset_;
+        size_t used_;
+    };
+
+    /// Arena of the current thread
+    static ScratchArena& local();
+
+    /// Uninitialized buffer of count limbs, valid until the end of the current scope
+    Limb* allocate(size_t count);
+
+    /// Total number of limbs owned by the arena
+    size_t capacity() const;
+
+    const Stats& stats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+
+  private:
+    static constexpr size_t kMinBlockSize = 1 << 12;
+
+    struct Block {
+        std::unique_ptr<Limb[]> data;
+        size_t size;
+    };
+
+    ScratchArena() = default;
+
+    /// Merges all blocks into one, called when nothing is allocated
+    void coalesce();
+
+    std::vector<Block> blocks_;
+    size_t block_ = 0;
+    size_t offset_ = 0;
+    size_t used_ = 0;
+    size_t depth_ = 0;
+    Stats stats_;
+};
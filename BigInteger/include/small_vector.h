@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+#include "big_integer_stats.h"
+
+/// Vector of trivially copyable values which keeps up to N of them inline
+/// and spills to the heap only when it grows beyond that.
+template <class T, size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector supports only trivial types");
+    static_assert(N > 0, "Inline capacity has to be positive");
+
+  public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+
+    explicit SmallVector(size_t count, const T& value = T()) {
+        assign(count, value);
+    }
+
+    SmallVector(std::initializer_list<T> init) {
+        assign(init.begin(), init.end());
+    }
+
+    template <class It, class = std::enable_if_t<!std::is_integral_v<It>>>
+    SmallVector(It first, It last) {
+        assign(first, last);
+    }
+
+    SmallVector(const SmallVector& other) {
+        assign(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector&& other) noexcept {
+        moveFrom(other);
+    }
+
+    ~SmallVector() {
+        release();
+    }
+
+    SmallVector& operator = (const SmallVector& other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector& operator = (SmallVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    SmallVector& operator = (std::initializer_list<T> init) {
+        assign(init.begin(), init.end());
+        return *this;
+    }
+
+    void assign(size_t count, const T& value) {
+        size_ = 0;
+        resize(count, value);
+    }
+
+    template <class It, class = std::enable_if_t<!std::is_integral_v<It>>>
+    void assign(It first, It last) {
+        const size_t count = static_cast<size_t>(std::distance(first, last));
+        if (count > capacity_) {
+            size_ = 0;
+            grow(count);
+        }
+        std::copy(first, last, data_);
+        size_ = count;
+    }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    /// True while the values are kept in the inline buffer
+    bool is_inline() const { return data_ == inline_; }
+
+    T& operator [] (size_t pos) { return data_[pos]; }
+    const T& operator [] (size_t pos) const { return data_[pos]; }
+
+    T& back() { return data_[size_ - 1]; }
+    const T& back() const { return data_[size_ - 1]; }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+    void reserve(size_t capacity) {
+        if (capacity > capacity_) {
+            grow(capacity);
+        }
+    }
+
+    void resize(size_t count, const T& value = T()) {
+        reserve(count);
+        if (count > size_) {
+            std::fill(data_ + size_, data_ + count, value);
+        }
+        size_ = count;
+    }
+
+    void push_back(const T& value) {
+        if (size_ == capacity_) {
+            grow(size_ + 1);
+        }
+        data_[size_++] = value;
+    }
+
+    void pop_back() {
+        assert(size_ > 0);
+        --size_;
+    }
+
+    void clear() {
+        size_ = 0;
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        T* dst = data_ + (first - data_);
+        const size_t tail = static_cast<size_t>(end() - last);
+        std::memmove(dst, last, tail * sizeof(T));
+        size_ -= static_cast<size_t>(last - first);
+        return dst;
+    }
+
+    void swap(SmallVector& other) noexcept {
+        SmallVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    bool operator == (const SmallVector& other) const {
+        return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+    }
+
+    bool operator != (const SmallVector& other) const {
+        return !(*this == other);
+    }
+
+  private:
+    void grow(size_t capacity) {
+        capacity = std::max(capacity, 2 * capacity_);
+        T* heap = new T[capacity];
+        BIGINTEGER_STATS_ALLOCATION(capacity * sizeof(T));
+        std::copy(data_, data_ + size_, heap);
+        release();
+        data_ = heap;
+        capacity_ = capacity;
+    }
+
+    void release() {
+        if (!is_inline()) {
+            delete[] data_;
+        }
+        data_ = inline_;
+        capacity_ = N;
+    }
+
+    /// REQUIREMENT: this has no heap buffer
+    void moveFrom(SmallVector& other) {
+        size_ = other.size_;
+        if (other.is_inline()) {
+            std::copy(other.data_, other.data_ + other.size_, inline_);
+        } else {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            other.data_ = other.inline_;
+            other.capacity_ = N;
+        }
+        other.size_ = 0;
+    }
+
+    T* data_{inline_};
+    size_t size_{0};
+    size_t capacity_{N};
+    T inline_[N];
+};
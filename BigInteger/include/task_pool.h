@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Fork-join pool of worker threads for the recursive multiplication algorithms.
+/// Every worker has its own deque: it runs its newest tasks first and steals
+/// the oldest ones of the others when it runs out of work. A thread waiting
+/// for a group runs pending tasks meanwhile, so nested forks never block the pool.
+class TaskPool {
+  public:
+    using Task = std::function<void()>;
+
+    /// Tasks forked together, Wait() returns when all of them are done
+    class Group {
+      public:
+        explicit Group(TaskPool& pool);
+        /// Waits for the tasks which are still running
+        ~Group();
+
+        Group(const Group&) = delete;
+        Group& operator = (const Group&) = delete;
+
+        /// Without workers the task is run immediately in the calling thread
+        void Run(Task task);
+        void Wait();
+
+      private:
+        friend class TaskPool;
+
+        TaskPool& pool_;
+        std::atomic<size_t> pending_{0};
+    };
+
+    /// Zero workers make every group run its tasks in the calling thread
+    explicit TaskPool(size_t workers);
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator = (const TaskPool&) = delete;
+
+    size_t GetWorkers() const;
+
+    /// Pool shared by all BigInteger operations, hardware_concurrency() - 1 workers by default
+    static TaskPool& Global();
+    /// Not synchronized, has to be called while no other thread uses the global pool
+    static void SetGlobalWorkers(size_t workers);
+
+  private:
+    struct Item {
+        Task task;
+        Group* group;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Item> items;
+    };
+
+    void push(Item item);
+    /// Runs one task: the newest one of the own queue or the oldest one of another queue
+    bool tryRunOne();
+    void workerLoop(size_t index);
+    /// Queue of the calling thread, threads outside of the pool share the last one
+    size_t queueIndex() const;
+
+    size_t workers_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> queued_{0};
+    bool stop_ = false;
+};
@@ -0,0 +1,52 @@
+#include "barrett.h"
+
+#include <cassert>
+
+BarrettReducer::BarrettReducer(const BigInteger& modulus) : modulus_(modulus) {
+    assert(modulus_ > 0);
+    size_ = modulus_.num_.size();
+
+    BigInteger::Limbs power(2 * size_ + 1, 0);
+    power.back() = 1;
+    mu_ = BigInteger(std::move(power)) / modulus_;
+}
+
+const BigInteger& BarrettReducer::GetModulus() const {
+    return modulus_;
+}
+
+BigInteger BarrettReducer::reduce(const BigInteger& x) const {
+    return reduce(BigInteger(x));
+}
+
+BigInteger BarrettReducer::reduce(BigInteger&& x) const {
+    if (!x.IsPositive() || x.num_.size() > 2 * size_) {
+        return BigInteger::mod(std::move(x), modulus_);
+    }
+    if (x < modulus_) {
+        return std::move(x);
+    }
+
+    /// q = [[x / b^(k - 1)] * mu / b^(k + 1)] is at most 2 less than [x / N]
+    BigInteger q(BigInteger::Limbs(x.num_.begin() + (size_ - 1), x.num_.end()));
+    q *= mu_;
+    if (q.num_.size() > size_ + 1) {
+        q.num_.erase(q.num_.begin(), q.num_.begin() + (size_ + 1));
+    } else {
+        q = 0;
+    }
+
+    x -= q * modulus_;
+    while (x >= modulus_) {
+        x -= modulus_;
+    }
+    return std::move(x);
+}
+
+BigInteger BarrettReducer::mulmod(const BigInteger& lhs, const BigInteger& rhs) const {
+    return reduce(lhs * rhs);
+}
+
+BigInteger BarrettReducer::sqrmod(const BigInteger& x) const {
+    return reduce(BigInteger::sqr(x));
+}
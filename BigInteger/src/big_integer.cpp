@@ -1,36 +1,484 @@
 #include "big_integer.h"
+#include "barrett.h"
+#include "big_integer_stats.h"
+#include "limb_kernels.h"
+#include "montgomery.h"
+#include "ntt.h"
+#include "scratch_arena.h"
+#include "task_pool.h"
 
 #include <utility>
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+
+#if defined(BIGINTEGER_STATS) && defined(BIGINTEGER_STATS_PROFILE)
+#include "easy/profiler.h"
+/// Counts the operation and measures the rest of the scope as a profiler block
+#define BIGINTEGER_OPERATION(operation, limbs) \
+    BIGINTEGER_STATS_COUNT(operation, limbs); \
+    EASY_BLOCK("BigInteger::" #operation)
+#else
+#define BIGINTEGER_OPERATION(operation, limbs) BIGINTEGER_STATS_COUNT(operation, limbs)
+#endif
 
 // TODO: Use static_cast<> instead of C-style casts
 
 namespace {
-// True if lhs < rhs
-    bool CompareTwoDigitalVectors(const std::vector<BigInteger::Digit>& lhs,
-                                  const std::vector<BigInteger::Digit>& rhs) {
-        if (lhs.size() < rhs.size()) return true;
-        for (auto i = lhs.size(); i > 0; --i) {
-            if (lhs[i - 1] != rhs[i - 1]) {
-                return lhs[i - 1] < rhs[i - 1];
+    using Limb = BigInteger::Limb;
+    using Limbs = BigInteger::Limbs;
+
+    /// The biggest power of ten which fits into one limb
+    constexpr Limb kDecimalBase = 10000000000000000000ull;
+    constexpr int kDecimalBaseDigits = 19;
+    /// Numbers up to this many limbs are converted to/from decimal chunk by chunk,
+    /// longer ones are split in halves by a power of ten
+    constexpr size_t kDecimalConversionThreshold = 32;
+
+    /// Header of the binary form: the sign flag and the number of magnitude bytes
+    constexpr size_t kHeaderSize = 4;
+    constexpr uint32_t kNegativeFlag = uint32_t(1) << 31;
+
+    /// Limbs needed for count digits of bits_per_digit_x1000 / 1000 bits each
+    [[maybe_unused]] size_t LimbsForDigits(size_t count, size_t bits_per_digit_x1000) {
+        return (count * bits_per_digit_x1000 / 1000 + BigInteger::kLimbBits - 1) / BigInteger::kLimbBits;
+    }
+
+    /// number = number * mul + add
+    void MulAddSmall(Limbs& number, Limb mul, Limb add) {
+        unsigned __int128 carry = add;
+        for (auto& limb : number) {
+            unsigned __int128 cur = (unsigned __int128)limb * mul + carry;
+            limb = static_cast<Limb>(cur);
+            carry = cur >> 64;
+        }
+        if (carry != 0) {
+            number.push_back(static_cast<Limb>(carry));
+        }
+    }
+
+    /// number mod divisor without the quotient
+    Limb ModSmall(const Limbs& number, Limb divisor) {
+        unsigned __int128 remainder = 0;
+        for (auto i = number.size(); i > 0; --i) {
+            remainder = ((remainder << 64) | number[i - 1]) % divisor;
+        }
+        return static_cast<Limb>(remainder);
+    }
+
+    /// number = number / divisor, returns remainder
+    Limb DivideBySmall(Limbs& number, Limb divisor) {
+        unsigned __int128 remainder = 0;
+        for (auto i = number.size(); i > 0; --i) {
+            unsigned __int128 cur = (remainder << 64) | number[i - 1];
+            number[i - 1] = static_cast<Limb>(cur / divisor);
+            remainder = cur % divisor;
+        }
+        while (number.size() > 1 && number.back() == 0) {
+            number.pop_back();
+        }
+        return static_cast<Limb>(remainder);
+    }
+
+    /// number = number + add
+    void AddSmall(Limbs& number, Limb add) {
+        for (auto& limb : number) {
+            limb += add;
+            if (limb >= add) {
+                return;
             }
+            add = 1;
         }
-        return false;
+        number.push_back(add);
+    }
+
+    /// number = number - sub
+    /// REQUIREMENT: number >= sub
+    void SubtractSmall(Limbs& number, Limb sub) {
+        for (auto& limb : number) {
+            Limb prev = limb;
+            limb -= sub;
+            if (prev >= sub) {
+                break;
+            }
+            sub = 1;
+        }
+        while (number.size() > 1 && number.back() == 0) {
+            number.pop_back();
+        }
+    }
+
+    /// result[0, na + nb) = a[0, na) * b[0, nb)
+    void MulSchoolbook(const Limb* a, size_t na, const Limb* b, size_t nb, Limb* result) {
+        std::fill(result, result + na + nb, 0);
+        for (size_t i = 0; i < na; ++i) {
+            result[i + nb] = LimbKernels::AddMul(result + i, b, nb, a[i]);
+        }
+    }
+
+    /// a[0, na) += b[0, nb), returns the carry out of a
+    /// REQUIREMENT: na >= nb
+    Limb AddTo(Limb* a, size_t na, const Limb* b, size_t nb) {
+        Limb carry = LimbKernels::Add(a, a, b, nb);
+        for (size_t pos = nb; carry != 0 && pos < na; ++pos) {
+            a[pos] += carry;
+            carry = (a[pos] == 0 ? 1 : 0);
+        }
+        return carry;
+    }
+
+    /// a[0, na) -= b[0, nb), returns the borrow out of a
+    /// REQUIREMENT: na >= nb
+    Limb SubtractFrom(Limb* a, size_t na, const Limb* b, size_t nb) {
+        Limb borrow = LimbKernels::Sub(a, a, b, nb);
+        for (size_t pos = nb; borrow != 0 && pos < na; ++pos) {
+            borrow = (a[pos] == 0 ? 1 : 0);
+            a[pos] -= 1;
+        }
+        return borrow;
+    }
+
+    BigInteger::MultiplicationThresholds multiplication_thresholds;
+
+    /// Subproducts of n limbs are forked to the task pool
+    bool IsParallel(size_t n) {
+        return n >= multiplication_thresholds.parallel && TaskPool::Global().GetWorkers() > 0;
     }
 
-    long long DividePrefixWithBinarySearch(const BigInteger& lhs, const BigInteger& rhs) {
-        int l = 0;
-        int r = 9;
-        while (l < r) {
-            int mid = (l + r + 1) >> 1;
-            if ((rhs * mid) <= lhs) {
-                l = mid;
-            } else {
-                r = mid - 1;
+    /// result[0, 2n) = a[0, n) * b[0, n), temporaries are taken from the scratch arena
+    void MulKaratsuba(const Limb* a, const Limb* b, size_t n, Limb* result, size_t threshold) {
+        if (n <= std::max<size_t>(threshold, 3)) {
+            MulSchoolbook(a, n, b, n, result);
+            return;
+        }
+
+        /// A = A0 + A1 * Base ^ M, B = B0 + B1 * Base ^ M
+        /// A * B = A0 * B0 + ((A0 + A1) * (B0 + B1) - A0 * B0 - A1 * B1) * Base ^ M
+        ///       + A1 * B1 * Base ^ 2M
+        const size_t low = n / 2;
+        const size_t high = n - low;
+        ScratchArena::Scope scope;
+        Limb* a_sum = scope.arena().allocate(high + 1);
+        Limb* b_sum = scope.arena().allocate(high + 1);
+        Limb* middle = scope.arena().allocate(2 * (high + 1));
+        std::copy(a + low, a + n, a_sum);
+        a_sum[high] = AddTo(a_sum, high, a, low);
+        std::copy(b + low, b + n, b_sum);
+        b_sum[high] = AddTo(b_sum, high, b, low);
+
+        /// The outer products go to other workers, tasks use scratch arenas of their threads
+        if (IsParallel(n)) {
+            TaskPool::Group group(TaskPool::Global());
+            group.Run([=] { MulKaratsuba(a, b, low, result, threshold); });
+            group.Run([=] { MulKaratsuba(a + low, b + low, high, result + 2 * low, threshold); });
+            MulKaratsuba(a_sum, b_sum, high + 1, middle, threshold);
+            group.Wait();
+        } else {
+            MulKaratsuba(a, b, low, result, threshold);
+            MulKaratsuba(a + low, b + low, high, result + 2 * low, threshold);
+            MulKaratsuba(a_sum, b_sum, high + 1, middle, threshold);
+        }
+        SubtractFrom(middle, 2 * (high + 1), result, 2 * low);
+        SubtractFrom(middle, 2 * (high + 1), result + 2 * low, 2 * high);
+        /// A0 * B1 + A1 * B0 < Base ^ (n + 1), so the upper limbs of middle are zeros
+        AddTo(result + low, n + high, middle, std::min(2 * (high + 1), n + high));
+    }
+
+    /// Numbers of at most this number of limbs go to the binary gcd, longer ones to Lehmer's
+    constexpr size_t kBinaryGcdThreshold = 4;
+
+    /// number = number >> bits
+    void ShiftRight(Limbs& number, size_t bits) {
+        const size_t limbs = std::min(bits / 64, number.size());
+        number.erase(number.begin(), number.begin() + limbs);
+        bits %= 64;
+        if (bits != 0) {
+            for (size_t i = 0; i < number.size(); ++i) {
+                const Limb next = (i + 1 < number.size() ? number[i + 1] : 0);
+                number[i] = (number[i] >> bits) | (next << (64 - bits));
             }
         }
-        return l;
+        while (number.size() > 1 && number.back() == 0) {
+            number.pop_back();
+        }
+        if (number.empty()) {
+            number.push_back(0);
+        }
+    }
+
+    /// number = number << bits
+    void ShiftLeft(Limbs& number, size_t bits) {
+        const size_t limbs = bits / 64;
+        bits %= 64;
+        const size_t size = number.size();
+        number.resize(size + limbs + 1, 0);
+        for (size_t i = size + limbs + 1; i > limbs; --i) {
+            const size_t from = i - 1 - limbs;
+            const Limb high = (from < size ? number[from] : 0);
+            const Limb low = (bits != 0 && from > 0 ? number[from - 1] >> (64 - bits) : 0);
+            number[i - 1] = (bits != 0 ? high << bits : high) | low;
+        }
+        std::fill(number.begin(), number.begin() + limbs, 0);
+        while (number.size() > 1 && number.back() == 0) {
+            number.pop_back();
+        }
+    }
+
+    /// REQUIREMENT: number != 0
+    size_t CountTrailingZeros(const Limbs& number) {
+        size_t pos = 0;
+        while (number[pos] == 0) {
+            ++pos;
+        }
+        return pos * 64 + __builtin_ctzll(number[pos]);
+    }
+
+    /// Limbs of the two's complement form of a signed magnitude one by one, infinitely sign-extended:
+    /// -m = ~(m - 1), the borrow of m - 1 runs through the zero limbs at the bottom
+    class TwosComplement {
+      public:
+        TwosComplement(const Limbs& magnitude, bool is_negative)
+            : magnitude_(magnitude), is_negative_(is_negative), borrow_(is_negative) {}
+
+        Limb Next() {
+            const Limb limb = (pos_ < magnitude_.size() ? magnitude_[pos_] : 0);
+            ++pos_;
+            if (!is_negative_) {
+                return limb;
+            }
+            const Limb result = ~(limb - borrow_);
+            borrow_ = (borrow_ && limb == 0);
+            return result;
+        }
+
+      private:
+        /// Reference, so the magnitude may be the result of Bitwise growing in place
+        const Limbs& magnitude_;
+        bool is_negative_;
+        Limb borrow_;
+        size_t pos_ = 0;
+    };
+
+    /// Magnitude of (lhs op rhs) on two's complement forms into result, returns the sign,
+    /// result may be the same object as LHS or RHS
+    template <class Op>
+    bool Bitwise(const Limbs& lhs, bool lhs_negative, const Limbs& rhs, bool rhs_negative,
+                 Limbs& result, Op op) {
+        const bool is_negative = (op(lhs_negative ? ~Limb(0) : 0, rhs_negative ? ~Limb(0) : 0) != 0);
+        const size_t size = std::max(lhs.size(), rhs.size());
+        TwosComplement lhs_limbs(lhs, lhs_negative), rhs_limbs(rhs, rhs_negative);
+        result.resize(size, 0);
+        for (size_t i = 0; i < size; ++i) {
+            const Limb lhs_limb = lhs_limbs.Next();
+            result[i] = op(lhs_limb, rhs_limbs.Next());
+        }
+        if (is_negative) {
+            /// The magnitude of a negative result is ~result + 1
+            Limb carry = 1;
+            for (size_t i = 0; i < size; ++i) {
+                result[i] = ~result[i] + carry;
+                carry = (carry != 0 && result[i] == 0);
+            }
+            if (carry != 0) {
+                result.push_back(1);
+            }
+        }
+        return is_negative;
+    }
+
+    Limb BinaryGcd(Limb a, Limb b) {
+        if (a == 0 || b == 0) {
+            return a | b;
+        }
+        const int shift = __builtin_ctzll(a | b);
+        a >>= __builtin_ctzll(a);
+        while (b != 0) {
+            b >>= __builtin_ctzll(b);
+            if (a > b) {
+                std::swap(a, b);
+            }
+            b -= a;
+        }
+        return a << shift;
+    }
+
+    /// The bits [shift, shift + 63) of number
+    __int128 TopBits(const Limbs& number, size_t shift) {
+        const size_t pos = shift / 64;
+        const size_t bits = shift % 64;
+        if (pos >= number.size()) {
+            return 0;
+        }
+        unsigned __int128 value = number[pos];
+        if (pos + 1 < number.size()) {
+            value |= (unsigned __int128)number[pos + 1] << 64;
+        }
+        return static_cast<__int128>((value >> bits) & ((Limb(1) << 63) - 1));
+    }
+
+    /// Cofactors of several Euclid's steps: (lhs, rhs) -> (a * lhs + b * rhs, c * lhs + d * rhs)
+    struct LehmerMatrix {
+        __int128 a, b, c, d;
+    };
+
+    /// Lehmer's algorithm (Knuth, algorithm 4.5.2L): Euclid's steps are simulated
+    /// on the leading 63 bits while the quotients are surely the same as for the
+    /// full numbers. b == 0 means that not even one step is certain.
+    /// All of the cofactors are less than 2^63 by absolute value.
+    /// REQUIREMENT: lhs >= rhs, lhs has at least two limbs
+    LehmerMatrix GetLehmerMatrix(const Limbs& lhs, const Limbs& rhs) {
+        const size_t bit_length = lhs.size() * 64 - __builtin_clzll(lhs.back());
+        const size_t shift = bit_length - 63;
+        __int128 x = TopBits(lhs, shift);
+        __int128 y = TopBits(rhs, shift);
+        LehmerMatrix m{1, 0, 0, 1};
+        while (y + m.c > 0 && y + m.d > 0) {
+            const __int128 q = (x + m.a) / (y + m.c);
+            if (q != (x + m.b) / (y + m.d)) {
+                break;
+            }
+            __int128 t = m.a - q * m.c;
+            m.a = m.c;
+            m.c = t;
+            t = m.b - q * m.d;
+            m.b = m.d;
+            m.d = t;
+            t = x - q * y;
+            x = y;
+            y = t;
+        }
+        return m;
+    }
+
+    /// result = x * a + y * b, where x and y have different signs, |x|, |y| < 2^63
+    /// REQUIREMENT: the result is not negative, a is not shorter than b
+    void LinearCombination(const Limbs& a, const Limbs& b, __int128 x, __int128 y, Limbs& result) {
+        result.resize(a.size());
+        __int128 carry = 0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            carry += x * static_cast<__int128>(a[i]);
+            if (i < b.size()) {
+                carry += y * static_cast<__int128>(b[i]);
+            }
+            result[i] = static_cast<Limb>(carry);
+            carry >>= 64;
+        }
+        assert(carry == 0);
+        while (result.size() > 1 && result.back() == 0) {
+            result.pop_back();
+        }
+    }
+
+    /// result[0, 2n) = a[0, n) ^ 2: cross products a[i] * a[j], i < j, are summed once
+    /// and doubled by a shift, then the squares of single limbs are added
+    void SqrSchoolbook(const Limb* a, size_t n, Limb* result) {
+        std::fill(result, result + 2 * n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            result[i + n] = LimbKernels::AddMul(result + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+        }
+
+        Limb high_bit = 0;
+        for (size_t i = 0; i < 2 * n; ++i) {
+            const Limb next = result[i] >> 63;
+            result[i] = (result[i] << 1) | high_bit;
+            high_bit = next;
+        }
+
+        Limb carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const unsigned __int128 square = (unsigned __int128)a[i] * a[i];
+            unsigned __int128 cur = (unsigned __int128)result[2 * i] + static_cast<Limb>(square) + carry;
+            result[2 * i] = static_cast<Limb>(cur);
+            cur = (unsigned __int128)result[2 * i + 1] + static_cast<Limb>(square >> 64) +
+                  static_cast<Limb>(cur >> 64);
+            result[2 * i + 1] = static_cast<Limb>(cur);
+            carry = static_cast<Limb>(cur >> 64);
+        }
+    }
+
+    /// result[0, 2n) = a[0, n) ^ 2, the same scheme as MulKaratsuba with three squarings
+    void SqrKaratsuba(const Limb* a, size_t n, Limb* result, size_t threshold) {
+        if (n <= std::max<size_t>(threshold, 3)) {
+            SqrSchoolbook(a, n, result);
+            return;
+        }
+
+        const size_t low = n / 2;
+        const size_t high = n - low;
+        ScratchArena::Scope scope;
+        Limb* sum = scope.arena().allocate(high + 1);
+        Limb* middle = scope.arena().allocate(2 * (high + 1));
+        std::copy(a + low, a + n, sum);
+        sum[high] = AddTo(sum, high, a, low);
+
+        if (IsParallel(n)) {
+            TaskPool::Group group(TaskPool::Global());
+            group.Run([=] { SqrKaratsuba(a, low, result, threshold); });
+            group.Run([=] { SqrKaratsuba(a + low, high, result + 2 * low, threshold); });
+            SqrKaratsuba(sum, high + 1, middle, threshold);
+            group.Wait();
+        } else {
+            SqrKaratsuba(a, low, result, threshold);
+            SqrKaratsuba(a + low, high, result + 2 * low, threshold);
+            SqrKaratsuba(sum, high + 1, middle, threshold);
+        }
+        SubtractFrom(middle, 2 * (high + 1), result, 2 * low);
+        SubtractFrom(middle, 2 * (high + 1), result + 2 * low, 2 * high);
+        AddTo(result + low, n + high, middle, std::min(2 * (high + 1), n + high));
+    }
+
+    /// 10^(19 * 2^k), computed on demand and kept for the lifetime of the thread
+    const BigInteger& DecimalPower(size_t k) {
+        static thread_local std::vector<BigInteger> powers{BigInteger::pow(10, kDecimalBaseDigits)};
+        while (powers.size() <= k) {
+            powers.push_back(BigInteger::sqr(powers.back()));
+        }
+        return powers[k];
+    }
+
+    /// Symbols of the magnitude in base 2^bits from the most significant one,
+    /// zero is written as a single symbol
+    template <class ToSymbol>
+    std::string ToPowerOfTwoBase(const Limbs& number, size_t bit_length, int bits, ToSymbol to_symbol) {
+        const size_t count = std::max<size_t>((bit_length + bits - 1) / bits, 1);
+        const Limb mask = (Limb(1) << bits) - 1;
+        std::string result(count, '\0');
+        for (size_t i = 0, pos = 0; i < count; ++i, pos += bits) {
+            const size_t index = pos / BigInteger::kLimbBits;
+            const size_t offset = pos % BigInteger::kLimbBits;
+            Limb value = number[index] >> offset;
+            if (offset + bits > BigInteger::kLimbBits && index + 1 < number.size()) {
+                value |= number[index + 1] << (BigInteger::kLimbBits - offset);
+            }
+            result[count - 1 - i] = to_symbol(static_cast<unsigned int>(value & mask));
+        }
+        return result;
+    }
+
+    /// Magnitude written by symbols in base 2^bits from the most significant one
+    template <class FromSymbol>
+    Limbs FromPowerOfTwoBase(const std::string& src, int bits, FromSymbol from_symbol) {
+        Limbs result(src.size() * bits / BigInteger::kLimbBits + 1, 0);
+        size_t pos = 0;
+        for (auto it = src.rbegin(); it != src.rend(); ++it, pos += bits) {
+            const Limb value = from_symbol(*it);
+            const size_t index = pos / BigInteger::kLimbBits;
+            const size_t offset = pos % BigInteger::kLimbBits;
+            result[index] |= value << offset;
+            if (offset + bits > BigInteger::kLimbBits) {
+                result[index + 1] |= value >> (BigInteger::kLimbBits - offset);
+            }
+        }
+        return result;
+    }
+
+    /// Magnitude of a machine integer, correct for LLONG_MIN as well
+    Limb Magnitude(long long number) {
+        return (number < 0 ? 0ull - static_cast<Limb>(number) : static_cast<Limb>(number));
     }
 
     char ToHex(unsigned int x) {
@@ -69,20 +517,12 @@ namespace {
 }  // namespace
 
 BigInteger::BigInteger(long long number) {
+    unsigned long long magnitude = static_cast<unsigned long long>(number);
     if (number < 0) {
-        number *= -1;
+        magnitude = 0ull - magnitude;
         is_positive_ = false;
     }
-    if (number == 0) {
-        num_ = {0};
-        return;
-    }
-
-    while (number != 0) {
-        num_.push_back(number % 10);
-        number /= 10;
-    }
-    return;
+    num_ = {magnitude};
 }
 
 BigInteger::BigInteger(const BigInteger& other) {
@@ -96,30 +536,16 @@ BigInteger::BigInteger(BigInteger&& other) noexcept {
 }
 
 BigInteger::BigInteger(const std::string& number) {
-    std::string tmp = number;
-    if (!tmp.empty() && tmp[0] == '-') {
+    BIGINTEGER_OPERATION(Convert, LimbsForDigits(number.size(), 3322));
+    size_t begin = 0;
+    if (!number.empty() && number[0] == '-') {
         is_positive_ = false;
-        tmp.erase(tmp.begin());
-    }
-    assert(tmp.size() > 0);
-    
-    std::vector<Digit> digits;
-    digits.reserve(tmp.size());
-    std::reverse(tmp.begin(), tmp.end());
-    for (int i = 0; i < tmp.size(); ++i) {
-        char c = tmp[i];
-        assert('0' <= c && c <= '9');
-        Digit d = c - '0';
-        digits.emplace_back(d);
-    }
-    
-    num_ = digits;
-    validate();
-}
+        begin = 1;
+    }
+    assert(number.size() > begin);
 
-BigInteger BigInteger::buildByDigitalVector(const std::vector<Digit>& number) {
-    if (number.empty()) return BigInteger(0);
-    return BigInteger(number);
+    num_ = parseDecimal(number.data() + begin, number.data() + number.size());
+    validate();
 }
 
 BigInteger BigInteger::zero() {
@@ -127,7 +553,7 @@ BigInteger BigInteger::zero() {
     return result;
 }
 
-const std::vector<BigInteger::Digit>& BigInteger::data() const {
+const BigInteger::Limbs& BigInteger::data() const {
     return num_;
 }
 
@@ -136,7 +562,7 @@ bool BigInteger::IsPositive() const {
 }
 
 size_t BigInteger::getLength() const {
-    return num_.size();
+    return abs(*this).ToString().size();
 }
 
 bool BigInteger::IsEven() const {
@@ -148,12 +574,29 @@ bool BigInteger::IsOdd() const {
 }
 
 BigInteger::Digit BigInteger::getDigitAt(int pos) const {
-    assert(pos > 0 && pos <= getLength());
-    return num_[getLength() - pos];
+    assert(pos > 0);
+    if (num_.size() == 1) {
+        /// At most 20 digits, counted and dropped by machine divisions
+        Limb value = num_[0];
+        size_t length = 1;
+        for (Limb rest = value; rest >= 10; rest /= 10) {
+            ++length;
+        }
+        assert(static_cast<size_t>(pos) <= length);
+        for (size_t i = pos; i < length; ++i) {
+            value /= 10;
+        }
+        return static_cast<Digit>(value % 10);
+    }
+    std::string digits;
+    appendDecimal(num_, 0, digits);
+    assert(static_cast<size_t>(pos) <= digits.size());
+    return static_cast<Digit>(digits[pos - 1] - '0');
 }
 
 bool BigInteger::operator == (long long other) const {
-    return *this == BigInteger(other);
+    return num_.size() == 1 && num_[0] == Magnitude(other) &&
+           (is_positive_ == (other >= 0) || other == 0);
 }
 
 bool BigInteger::operator == (const BigInteger& other) const {
@@ -245,11 +688,18 @@ BigInteger& BigInteger::operator = (BigInteger&& other) noexcept {
 
 
 
-BigInteger BigInteger::operator + (long long other) const {
-    return (*this) + BigInteger(other);
+BigInteger BigInteger::operator + (long long other) const & {
+    BigInteger result = *this;
+    result.addSmall(Magnitude(other), other >= 0);
+    return result;
 }
 
-BigInteger BigInteger::operator + (const BigInteger& other) const {
+BigInteger BigInteger::operator + (long long other) && {
+    addSmall(Magnitude(other), other >= 0);
+    return std::move(*this);
+}
+
+BigInteger BigInteger::operator + (const BigInteger& other) const & {
     BigInteger result;
 
     if (IsPositive() == other.IsPositive()) {
@@ -271,46 +721,119 @@ BigInteger BigInteger::operator + (const BigInteger& other) const {
     return result;
 }
 
+BigInteger BigInteger::operator + (const BigInteger& other) && {
+    *this += other;
+    return std::move(*this);
+}
+
+BigInteger BigInteger::operator + (BigInteger&& other) const & {
+    other += *this;
+    return std::move(other);
+}
+
+BigInteger BigInteger::operator + (BigInteger&& other) && {
+    *this += other;
+    return std::move(*this);
+}
+
 BigInteger& BigInteger::operator += (long long other) {
-    *this = *this + BigInteger(other);
+    addSmall(Magnitude(other), other >= 0);
     return *this;
 }
 
 BigInteger& BigInteger::operator += (const BigInteger& other) {
-    *this = *this + other;
+    if (this == &other) {
+        *this *= 2;
+        return *this;
+    }
+    addSigned(other.num_, other.is_positive_);
     return *this;
 }
 
-BigInteger BigInteger::operator - (long long other) const {
-    return *this - BigInteger(other);
+BigInteger BigInteger::operator - (long long other) const & {
+    BigInteger result = *this;
+    result.addSmall(Magnitude(other), other < 0);
+    return result;
+}
+
+BigInteger BigInteger::operator - (long long other) && {
+    addSmall(Magnitude(other), other < 0);
+    return std::move(*this);
+}
+
+BigInteger BigInteger::operator - (const BigInteger& other) const & {
+    BigInteger result;
+
+    if (IsPositive() != other.IsPositive()) {
+        result.num_ = getUnsignedSum(num_, other.num_);
+        result.is_positive_ = IsPositive();
+        result.validate();
+        return result;
+    }
+
+    auto unsigned_compare = compareUnsignedNumbers(num_, other.num_);
+    if (unsigned_compare != CompareSign::LESS) {
+        result.is_positive_ = is_positive_;
+        result.num_ = getUnsignedDiff(num_, other.num_);
+    } else {
+        result.is_positive_ = !is_positive_;
+        result.num_ = getUnsignedDiff(other.num_, num_);
+    }
+    result.validate();
+    return result;
+}
+
+BigInteger BigInteger::operator - (const BigInteger& other) && {
+    *this -= other;
+    return std::move(*this);
 }
 
-BigInteger BigInteger::operator - (BigInteger other) const {
+/// this - other = -(other - this), computed in the storage of other
+BigInteger BigInteger::operator - (BigInteger&& other) const & {
+    other -= *this;
     other.is_positive_ ^= 1;
-    return (*this) + other;
+    other.validateSign();
+    return std::move(other);
+}
+
+BigInteger BigInteger::operator - (BigInteger&& other) && {
+    *this -= other;
+    return std::move(*this);
 }
 
 BigInteger& BigInteger::operator -= (long long other) {
-    *this = *this - BigInteger(other);
+    addSmall(Magnitude(other), other < 0);
     return *this;
 }
 
 BigInteger& BigInteger::operator -= (const BigInteger& other) {
-    *this = *this - other;
+    if (this == &other) {
+        *this = 0;
+        return *this;
+    }
+    addSigned(other.num_, !other.is_positive_);
     return *this;
 }
 
-// TODO: Optimize multiplication on small-numbers
-BigInteger BigInteger::operator * (long long other) const {
-    return (*this) * BigInteger(other);
+BigInteger BigInteger::operator * (long long other) const & {
+    BigInteger result = *this;
+    result *= other;
+    return result;
+}
+
+BigInteger BigInteger::operator * (long long other) && {
+    *this *= other;
+    return std::move(*this);
 }
 
 BigInteger BigInteger::operator * (const BigInteger& other) const {
-    return KaratsubaMultiplication(*this, other);
+    return Multiplication(*this, other);
 }
 
 BigInteger& BigInteger::operator *= (long long other) {
-    *this *= BigInteger(other);
+    MulAddSmall(num_, Magnitude(other), 0);
+    is_positive_ = (is_positive_ == (other >= 0));
+    validate();
     return *this;
 }
 
@@ -319,96 +842,316 @@ BigInteger& BigInteger::operator *= (const BigInteger& other) {
     return *this;
 }
 
-BigInteger BigInteger::operator / (long long other) const {
-    return *this / BigInteger(other);
+BigInteger BigInteger::operator / (long long other) const & {
+    BigInteger quotient;
+    divmod_small(*this, other, quotient);
+    return quotient;
 }
 
-BigInteger BigInteger::operator / (const BigInteger& other) const {
-    if (other == zero()) {
-        exit(1);
-    }
-    DivisionResult division_result = getUnsignedDivision(*this, other);
-    BigInteger result = buildByDigitalVector(division_result.quotient);
+BigInteger BigInteger::operator / (long long other) && {
+    divmod_small(*this, other, *this);
+    return std::move(*this);
+}
 
-    if (IsPositive() == other.IsPositive()) {
-        result.is_positive_ = true;
-    } else {
-        result.is_positive_ = false;
-    }
-    result.validate();
+BigInteger BigInteger::operator / (const BigInteger& other) const & {
+    BigInteger quotient;
+    divide(*this, other, &quotient, nullptr);
+    return quotient;
+}
 
-    return result;
+BigInteger BigInteger::operator / (const BigInteger& other) && {
+    divide(*this, other, this, nullptr);
+    return std::move(*this);
 }
 
 BigInteger& BigInteger::operator /= (long long other) {
-    *this = *this / BigInteger(other);
+    divmod_small(*this, other, *this);
     return *this;
 }
 
 BigInteger& BigInteger::operator /= (const BigInteger& other) {
-    *this = *this / other;
+    divide(*this, other, this, nullptr);
     return *this;
 }
 
-BigInteger BigInteger::operator % (long long other) const {
-    return *this % BigInteger(other);
+BigInteger BigInteger::operator % (long long other) const & {
+    if (other == 0) {
+        exit(1);
+    }
+    BigInteger remainder;
+    remainder.num_[0] = ModSmall(num_, Magnitude(other));
+    remainder.is_positive_ = is_positive_;
+    remainder.validateSign();
+    return remainder;
+}
+
+BigInteger BigInteger::operator % (long long other) && {
+    *this %= other;
+    return std::move(*this);
 }
 
-BigInteger BigInteger::operator % (const BigInteger& other) const {
-    if (other == zero()) {
+BigInteger BigInteger::operator % (const BigInteger& other) const & {
+    BigInteger remainder;
+    divide(*this, other, nullptr, &remainder);
+    return remainder;
+}
+
+BigInteger BigInteger::operator % (const BigInteger& other) && {
+    divide(*this, other, nullptr, this);
+    return std::move(*this);
+}
+
+BigInteger& BigInteger::operator %= (long long other) {
+    if (other == 0) {
         exit(1);
     }
+    /// The remainder has the sign of this and fits into its lowest limb
+    const Limb remainder = ModSmall(num_, Magnitude(other));
+    num_.resize(1);
+    num_[0] = remainder;
+    validateSign();
+    return *this;
+}
 
-    DivisionResult division_result = getUnsignedDivision(*this, other);
+BigInteger& BigInteger::operator %= (const BigInteger& other) {
+    divide(*this, other, nullptr, this);
+    return *this;
+}
 
+BigInteger BigInteger::operator << (size_t shift) const & {
     BigInteger result;
-    result = buildByDigitalVector(division_result.remainder);
-    result.is_positive_ = IsPositive();
+    result.num_.reserve(num_.size() + shift / kLimbBits + 1);
+    result = *this;
+    result <<= shift;
+    return result;
+}
+
+BigInteger BigInteger::operator << (size_t shift) && {
+    *this <<= shift;
+    return std::move(*this);
+}
+
+BigInteger& BigInteger::operator <<= (size_t shift) {
+    ShiftLeft(num_, shift);
+    return *this;
+}
+
+BigInteger BigInteger::operator >> (size_t shift) const & {
+    BigInteger result = *this;
+    result >>= shift;
+    return result;
+}
+
+BigInteger BigInteger::operator >> (size_t shift) && {
+    *this >>= shift;
+    return std::move(*this);
+}
+
+BigInteger& BigInteger::operator >>= (size_t shift) {
+    /// -m >> k = -(m >> k) - 1 if a set bit of m is shifted out
+    const bool round_down = (!is_positive_ && CountTrailingZeros(num_) < shift);
+    ShiftRight(num_, shift);
+    if (round_down) {
+        AddSmall(num_, 1);
+    }
+    validateSign();
+    return *this;
+}
+
+BigInteger BigInteger::operator & (const BigInteger& other) const {
+    BigInteger result;
+    result.is_positive_ = !Bitwise(num_, !is_positive_, other.num_, !other.is_positive_, result.num_,
+                                   std::bit_and<Limb>());
     result.validate();
     return result;
 }
 
-BigInteger& BigInteger::operator %= (long long other) {
-    *this = *this % BigInteger(other);
+BigInteger BigInteger::operator | (const BigInteger& other) const {
+    BigInteger result;
+    result.is_positive_ = !Bitwise(num_, !is_positive_, other.num_, !other.is_positive_, result.num_,
+                                   std::bit_or<Limb>());
+    result.validate();
+    return result;
+}
+
+BigInteger BigInteger::operator ^ (const BigInteger& other) const {
+    BigInteger result;
+    result.is_positive_ = !Bitwise(num_, !is_positive_, other.num_, !other.is_positive_, result.num_,
+                                   std::bit_xor<Limb>());
+    result.validate();
+    return result;
+}
+
+BigInteger& BigInteger::operator &= (const BigInteger& other) {
+    is_positive_ = !Bitwise(num_, !is_positive_, other.num_, !other.is_positive_, num_,
+                            std::bit_and<Limb>());
+    validate();
     return *this;
 }
 
-BigInteger& BigInteger::operator %= (const BigInteger& other) {
-    *this = *this % other;
+BigInteger& BigInteger::operator |= (const BigInteger& other) {
+    is_positive_ = !Bitwise(num_, !is_positive_, other.num_, !other.is_positive_, num_,
+                            std::bit_or<Limb>());
+    validate();
+    return *this;
+}
+
+BigInteger& BigInteger::operator ^= (const BigInteger& other) {
+    is_positive_ = !Bitwise(num_, !is_positive_, other.num_, !other.is_positive_, num_,
+                            std::bit_xor<Limb>());
+    validate();
     return *this;
 }
 
 BigInteger BigInteger::pow(const BigInteger& number, const BigInteger& power) {
-    if (power == zero()) {
-        return BigInteger(1);
-    }
-    if (power.num_[0] & 1) {
-        return pow(number, power - 1) * number;
-    }
-    BigInteger w = pow(number, power / 2);
-    return w * w;
+    BIGINTEGER_OPERATION(Pow, number.num_.size());
+    assert(power.IsPositive());
+    return slidingWindowPow(number, BigInteger(1), power,
+                            [](const BigInteger& lhs, const BigInteger& rhs, BigInteger& result) {
+                                result = lhs * rhs;
+                            },
+                            [](const BigInteger& x, BigInteger& result) {
+                                result = sqr(x);
+                            });
 }
 
 BigInteger BigInteger::pow(const BigInteger& number, const BigInteger& power,
                           const BigInteger& module) {
-    if (power == zero()) {
-        return mod(BigInteger(1), module);
+    BIGINTEGER_OPERATION(Pow, module.num_.size());
+    assert(power.IsPositive());
+    if (module.IsOdd() && module > 1) {
+        return MontgomeryContext(module).pow(number, power);
+    }
+    return slidingWindowPow(mod(number, module), mod(BigInteger(1), module), power,
+                            [&module](const BigInteger& lhs, const BigInteger& rhs, BigInteger& result) {
+                                result = mod(lhs * rhs, module);
+                            },
+                            [&module](const BigInteger& x, BigInteger& result) {
+                                result = mod(sqr(x), module);
+                            });
+}
+
+BigInteger BigInteger::pow2(size_t power) {
+    Limbs result(power / kLimbBits + 1, 0);
+    result.back() = Limb(1) << (power % kLimbBits);
+    return BigInteger(std::move(result));
+}
+
+BigInteger BigInteger::multi_pow(const std::vector<BigInteger>& numbers,
+                                 const std::vector<BigInteger>& powers, const BigInteger& module) {
+    BIGINTEGER_OPERATION(Pow, module.num_.size());
+    assert(numbers.size() == powers.size());
+    for (const auto& power : powers) {
+        assert(power.IsPositive());
+    }
+    if (module.IsOdd() && module > 1) {
+        return MontgomeryContext(module).multi_pow(numbers, powers);
+    }
+
+    std::vector<BigInteger> residues;
+    residues.reserve(numbers.size());
+    for (const auto& number : numbers) {
+        residues.push_back(mod(number, module));
+    }
+    return slidingWindowMultiPow(residues, mod(BigInteger(1), module), powers,
+                                 [&module](const BigInteger& lhs, const BigInteger& rhs, BigInteger& result) {
+                                     result = mod(lhs * rhs, module);
+                                 },
+                                 [&module](const BigInteger& x, BigInteger& result) {
+                                     result = mod(sqr(x), module);
+                                 });
+}
+
+long long BigInteger::divmod_small(const BigInteger& lhs, long long rhs, BigInteger& quotient) {
+    if (rhs == 0) {
+        exit(1);
+    }
+    const bool quotient_sign = (lhs.IsPositive() == (rhs > 0));
+    const bool remainder_sign = lhs.IsPositive();
+
+    if (&quotient != &lhs) {
+        quotient.num_ = lhs.num_;
     }
-    if (power.getDigitAt(power.getLength()) & 1) {
-        return mod(pow(number, power - 1, module) * number, module);
+    Limb remainder = DivideBySmall(quotient.num_, Magnitude(rhs));
+    quotient.is_positive_ = quotient_sign;
+    quotient.validate();
+
+    return (remainder_sign ? static_cast<long long>(remainder)
+                           : -static_cast<long long>(remainder));
+}
+
+void BigInteger::addSmall(Limb magnitude, bool is_positive) {
+    if (is_positive_ == is_positive) {
+        AddSmall(num_, magnitude);
+    } else if (num_.size() > 1 || num_[0] >= magnitude) {
+        SubtractSmall(num_, magnitude);
+    } else {
+        num_[0] = magnitude - num_[0];
+        is_positive_ = is_positive;
     }
-    BigInteger w = pow(number, power / 2, module);
-    return mod(w * w, module);
+    validate();
+}
+
+void BigInteger::addSigned(const Limbs& magnitude, bool is_positive) {
+    if (is_positive_ == is_positive) {
+        if (num_.size() < magnitude.size()) {
+            num_.resize(magnitude.size(), 0);
+        }
+        if (AddTo(num_.data(), num_.size(), magnitude.data(), magnitude.size()) != 0) {
+            num_.push_back(1);
+        }
+    } else if (compareUnsignedNumbers(num_, magnitude) != CompareSign::LESS) {
+        SubtractFrom(num_.data(), num_.size(), magnitude.data(), magnitude.size());
+    } else {
+        /// |this| < |magnitude|, so num_ = magnitude - num_ doesn't borrow
+        num_.resize(magnitude.size(), 0);
+        LimbKernels::Sub(num_.data(), magnitude.data(), num_.data(), magnitude.size());
+        is_positive_ = is_positive;
+    }
+    validate();
+}
+
+size_t BigInteger::bit_length() const {
+    for (auto i = num_.size(); i > 0; --i) {
+        if (num_[i - 1] != 0) {
+            return (i - 1) * kLimbBits + (kLimbBits - __builtin_clzll(num_[i - 1]));
+        }
+    }
+    return 0;
+}
+
+bool BigInteger::test_bit(size_t pos) const {
+    const bool bit = (pos / kLimbBits < num_.size() && ((num_[pos / kLimbBits] >> (pos % kLimbBits)) & 1));
+    if (is_positive_) {
+        return bit;
+    }
+    /// -m = ~(m - 1): bits up to the lowest set one are the same as in m, the upper ones are inverted
+    return (pos <= CountTrailingZeros(num_) ? bit : !bit);
+}
+
+size_t BigInteger::count_trailing_zeros() const {
+    return (*this == 0 ? 0 : CountTrailingZeros(num_));
+}
+
+size_t BigInteger::getWindowSize(size_t bit_length) {
+    if (bit_length > 671) return 6;
+    if (bit_length > 239) return 5;
+    if (bit_length > 79) return 4;
+    if (bit_length > 23) return 3;
+    return 1;
 }
 
 
 void BigInteger::validateSign() {
-    if (num_.size() == 1 && num_.at(0) == 0) {
+    if (num_.size() == 1 && num_[0] == 0) {
         is_positive_ = true;
     }
 }
 
 void BigInteger::validate() {
+    if (num_.empty()) {
+        num_.push_back(0);
+    }
     while (num_.size() > 1 && num_.back() == 0) {
         num_.pop_back();
     }
@@ -416,8 +1159,8 @@ void BigInteger::validate() {
 }
 
 BigInteger::CompareSign BigInteger::compareUnsignedNumbers(
-        const std::vector<BigInteger::Digit>& lhs,
-        const std::vector<BigInteger::Digit>& rhs) {
+        const BigInteger::Limbs& lhs,
+        const BigInteger::Limbs& rhs) {
     if (lhs.size() != rhs.size()) {
         return (lhs.size() < rhs.size() ? CompareSign::LESS
                                         : CompareSign::GREATER);
@@ -431,217 +1174,394 @@ BigInteger::CompareSign BigInteger::compareUnsignedNumbers(
     return CompareSign::EQUAL;
 }
 
-std::vector<BigInteger::Digit> BigInteger::getUnsignedSum(const std::vector<Digit>& lhs,
-                                              const std::vector<Digit>& rhs) {
-    auto max_length = std::max(lhs.size(), rhs.size());
-    std::vector<Digit> sum(max_length + 1, 0);
+BigInteger::Limbs BigInteger::getUnsignedSum(const Limbs& lhs,
+                                             const Limbs& rhs) {
+    const auto& longer = (lhs.size() >= rhs.size() ? lhs : rhs);
+    const auto& shorter = (lhs.size() >= rhs.size() ? rhs : lhs);
+    Limbs sum(longer.size() + 1, 0);
 
-    long long d = 0;
-    for (long long i = 0; i < max_length; ++i) {
-        long long c = (i < lhs.size() ? lhs[i] : 0) + (i < rhs.size() ? rhs[i] : 0) + d;
-        sum[i] = c % 10;
-        d = c > 9 ? 1 : 0;
+    Limb carry = LimbKernels::Add(sum.data(), longer.data(), shorter.data(), shorter.size());
+    for (size_t i = shorter.size(); i < longer.size(); ++i) {
+        sum[i] = longer[i] + carry;
+        carry = (sum[i] < carry ? 1 : 0);
     }
-    if (d) sum.back() = 1;
+    if (carry) sum.back() = carry;
     else sum.pop_back();
 
     return sum;
 }
 
-std::vector<BigInteger::Digit> BigInteger::getUnsignedDiff(const std::vector<Digit>& lhs,
-                                               const std::vector<Digit>& rhs) {
+BigInteger::Limbs BigInteger::getUnsignedDiff(const Limbs& lhs,
+                                              const Limbs& rhs) {
     if (lhs.size() < rhs.size()) {
         exit(1);
     }
 
-    std::vector<Digit> diff(lhs.size(), 0);
-    long long d = 0;
-    for (long long i = 0; i < lhs.size(); ++i) {
-        long long c = (lhs[i] - d - (i < rhs.size() ? rhs[i] : 0));
-        if (c >= 0) {
-            d = 0;
-            diff[i] = c;
-        } else {
-            d = 1;
-            diff[i] = 10 + c;
-        }
+    Limbs diff(lhs.size(), 0);
+    Limb borrow = LimbKernels::Sub(diff.data(), lhs.data(), rhs.data(), rhs.size());
+    for (size_t i = rhs.size(); i < lhs.size(); ++i) {
+        diff[i] = lhs[i] - borrow;
+        borrow = (lhs[i] < borrow ? 1 : 0);
     }
 
-    if (d != 0) {
+    if (borrow != 0) {
         exit(1);
     }
     return diff;
 }
 
-BigInteger::DivisionResult BigInteger::getUnsignedDivision(BigInteger lhs,
-                                                           BigInteger rhs) {
-    BigInteger::DivisionResult result;
-
-    if (lhs.num_.size() < rhs.num_.size()) {
-        result.quotient = {0};
-        result.remainder = lhs.num_;
-        return result;
+void BigInteger::getUnsignedDivision(const Limbs& lhs,
+                                     const Limbs& rhs,
+                                     Limbs* quotient,
+                                     Limbs* remainder) {
+    BIGINTEGER_OPERATION(Divide, lhs.size() + rhs.size());
+    if (compareUnsignedNumbers(lhs, rhs) == CompareSign::LESS) {
+        if (remainder) {
+            *remainder = lhs;
+        }
+        if (quotient) {
+            quotient->assign(1, 0);
+        }
+        return;
     }
 
-    lhs.is_positive_ = true;
-    rhs.is_positive_ = true;
-    const long long kLen((long long)rhs.num_.size());
-
-    std::vector<Digit> quotient((long long)lhs.num_.size() - kLen + 1, 0);
-    while (rhs <= lhs) {
-        long long cur_len = kLen;
-
-        std::vector<Digit> prefix;
-        prefix.reserve(cur_len);
-        for (long long i = cur_len; i > 0; --i) {
-            prefix.push_back(lhs.num_[(long long)lhs.num_.size() - i]);
+    if (rhs.size() == 1) {
+        const Limb divisor = rhs[0];
+        Limb residue;
+        if (quotient) {
+            *quotient = lhs;
+            residue = DivideBySmall(*quotient, divisor);
+        } else {
+            residue = ModSmall(lhs, divisor);
+        }
+        if (remainder) {
+            remainder->assign(1, residue);
         }
+        return;
+    }
 
-        BigInteger c = buildByDigitalVector(prefix);
-        if (rhs > c) {
-            ++cur_len;
-            prefix.insert(prefix.begin(), lhs.num_[(long long)lhs.num_.size() - cur_len]);
-            c = buildByDigitalVector(prefix);
+    /// Normalize operands, so the most significant bit of the divisor is set,
+    /// then the estimation of every quotient limb by the two leading limbs
+    /// of the remainder is at most 2 greater than the real one
+    const size_t n = rhs.size();
+    const size_t m = lhs.size() - n;
+    const int shift = __builtin_clzll(rhs.back());
+
+    ScratchArena::Scope scope;
+    Limb* v = scope.arena().allocate(n);
+    Limb* u = scope.arena().allocate(lhs.size() + 1);
+    for (size_t i = n; i > 0; --i) {
+        v[i - 1] = (rhs[i - 1] << shift) | (shift && i > 1 ? rhs[i - 2] >> (kLimbBits - shift) : 0);
+    }
+    u[lhs.size()] = (shift ? lhs.back() >> (kLimbBits - shift) : 0);
+    for (size_t i = lhs.size(); i > 0; --i) {
+        u[i - 1] = (lhs[i - 1] << shift) | (shift && i > 1 ? lhs[i - 2] >> (kLimbBits - shift) : 0);
+    }
+
+    if (quotient) {
+        quotient->assign(m + 1, 0);
+    }
+    for (size_t j = m + 1; j > 0; --j) {
+        const size_t pos = j - 1;
+        DoubleLimb numerator = ((DoubleLimb)u[pos + n] << kLimbBits) | u[pos + n - 1];
+        DoubleLimb q_hat = numerator / v[n - 1];
+        DoubleLimb r_hat = numerator % v[n - 1];
+        while ((q_hat >> kLimbBits) != 0 ||
+               q_hat * v[n - 2] > ((r_hat << kLimbBits) | u[pos + n - 2])) {
+            --q_hat;
+            r_hat += v[n - 1];
+            if ((r_hat >> kLimbBits) != 0) {
+                break;
+            }
         }
 
-        long long k = DividePrefixWithBinarySearch(c, rhs);
-        quotient[(long long)lhs.num_.size() - cur_len] = k;
-        c -= rhs * k;
+        /// u[pos, pos + n] -= q_hat * v
+        const Limb borrow = LimbKernels::SubMul(u + pos, v, n, static_cast<Limb>(q_hat));
+        const bool negative = (u[pos + n] < borrow);
+        u[pos + n] -= borrow;
 
-        for (long long i = cur_len; i > 0; --i) {
-            lhs.num_[(long long)lhs.num_.size() - i] = 0;
+        /// The estimation was 1 too big, add the divisor back
+        if (negative) {
+            --q_hat;
+            u[pos + n] += LimbKernels::Add(u + pos, u + pos, v, n);
         }
-        for (long long i = 0; i < c.num_.size(); ++i) {
-            lhs.num_[(long long)lhs.num_.size() - cur_len + i] = c.num_[i];
+        if (quotient) {
+            (*quotient)[pos] = static_cast<Limb>(q_hat);
         }
-        lhs.validate();
     }
 
-    result.quotient = quotient;
-    result.remainder = lhs.num_;
-    return result;
+    if (remainder) {
+        remainder->resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            (*remainder)[i] = (u[i] >> shift) | (shift ? u[i + 1] << (kLimbBits - shift) : 0);
+        }
+    }
 }
 
 BigInteger BigInteger::NativeMultiplication(const BigInteger& lhs, const BigInteger& rhs) {
-    // TODO: Optimize multiplication on small numbers
-    std::vector<Digit> mult(lhs.num_.size() + rhs.num_.size(), 0);
-    for (long long i = 0; i < lhs.num_.size(); ++i) {
-        for (long long j = 0, d = 0; j < rhs.num_.size() || d != 0; ++j) {
-            long long cur = (long long)lhs.num_[i] * (long long)(j < rhs.num_.size() ? rhs.num_[j] : 0)
-                            + (long long)mult[i + j] + d;
-            mult[i + j] = cur % 10;
-            d = cur / 10;
-        }
-    }
+    BIGINTEGER_OPERATION(Schoolbook, lhs.num_.size() + rhs.num_.size());
     BigInteger result;
-    result.num_ = mult;
+    result.num_.resize(lhs.num_.size() + rhs.num_.size());
+    MulSchoolbook(lhs.num_.data(), lhs.num_.size(), rhs.num_.data(), rhs.num_.size(),
+                  result.num_.data());
     result.is_positive_ = (lhs.IsPositive() == rhs.IsPositive() ? true : false);
     result.validate();
     return result;
 }
 
 BigInteger BigInteger::KaratsubaMultiplication(const BigInteger& lhs, const BigInteger& rhs) {
+    BIGINTEGER_OPERATION(Karatsuba, lhs.num_.size() + rhs.num_.size());
     if (lhs == BigInteger::zero() || rhs == BigInteger::zero()) {
         return BigInteger::zero();
     }
 
-    if (std::min(lhs.getLength(), rhs.getLength()) <= 100) {
+    const size_t threshold = multiplication_thresholds.karatsuba;
+    if (std::min(lhs.num_.size(), rhs.num_.size()) <= threshold) {
         return NativeMultiplication(lhs, rhs);
     }
 
-    // TODO: Multiple by integer (not BigInteger), when one of numbers is small
-    struct NumberDivision {
-        BigInteger lhs, rhs;
-        bool sign;
-    };
-    auto GetDivision = [](const BigInteger& number, int rhs_len) {
-        NumberDivision result;
-        result.sign = number.IsPositive();
-
-        int len = number.getLength();
-        if (len <= rhs_len) {
-            result.lhs = BigInteger::zero();
-            result.rhs = number;
-            return result;
-        }
+    /// The longer operand is cut into pieces of the length of the shorter one,
+    /// every piece is multiplied by balanced Karatsuba and added to the result
+    const Limbs& longer = (lhs.num_.size() >= rhs.num_.size() ? lhs.num_ : rhs.num_);
+    const Limbs& shorter = (lhs.num_.size() >= rhs.num_.size() ? rhs.num_ : lhs.num_);
+    const size_t n = shorter.size();
+    const size_t total = longer.size() + n;
 
-        std::vector<Digit> rhs_part;
-        rhs_part.reserve(rhs_len);
-        for (int i = 0; i < rhs_len; ++i) {
-            rhs_part.push_back(number.num_[i]);
+    BigInteger result;
+    result.num_.assign(total, 0);
+
+    ScratchArena::Scope scope;
+    Limb* product = scope.arena().allocate(2 * n);
+    for (size_t pos = 0; pos < longer.size(); pos += n) {
+        const size_t len = std::min(n, longer.size() - pos);
+        const Limb* piece = longer.data() + pos;
+        if (len < n) {
+            Limb* padded = scope.arena().allocate(n);
+            std::copy(piece, piece + len, padded);
+            std::fill(padded + len, padded + n, 0);
+            piece = padded;
         }
-        result.rhs = BigInteger(rhs_part);
+        MulKaratsuba(piece, shorter.data(), n, product, threshold);
+        AddTo(result.num_.data() + pos, total - pos, product, std::min(2 * n, total - pos));
+    }
+
+    result.is_positive_ = (lhs.IsPositive() == rhs.IsPositive());
+    result.validate();
+    return result;
+}
+
+BigInteger BigInteger::ToomCook3Multiplication(const BigInteger& lhs, const BigInteger& rhs) {
+    BIGINTEGER_OPERATION(ToomCook3, lhs.num_.size() + rhs.num_.size());
+    if (lhs == BigInteger::zero() || rhs == BigInteger::zero()) {
+        return BigInteger::zero();
+    }
 
-        std::vector<Digit> lhs_part;
-        lhs_part.reserve(len - rhs_len);
-        for (int i = rhs_len; i < len; ++i) {
-            lhs_part.push_back(number.num_[i]);
+    /// A = A0 + A1 * x + A2 * x^2, x = Base ^ k, the same for B.
+    /// A * B is a polynomial of degree 4, it is restored from its values
+    /// at 0, 1, -1, -2 and infinity (Bodrato's interpolation sequence)
+    const size_t k = (std::max(lhs.num_.size(), rhs.num_.size()) + 2) / 3;
+    auto Split = [k](const BigInteger& number, BigInteger parts[3]) {
+        const Limbs& limbs = number.num_;
+        for (size_t i = 0; i < 3; ++i) {
+            const size_t from = std::min(i * k, limbs.size());
+            const size_t to = std::min(from + k, limbs.size());
+            parts[i] = (from < to ? BigInteger(Limbs(limbs.begin() + from, limbs.begin() + to))
+                                  : BigInteger::zero());
         }
-        result.lhs = BigInteger(lhs_part);
+    };
+    /// Squaring evaluates one operand and squares the values
+    const bool square = (&lhs == &rhs);
+    BigInteger a[3], b[3];
+    Split(lhs, a);
+    if (!square) {
+        Split(rhs, b);
+    }
+
+    auto Evaluate = [](const BigInteger parts[3], BigInteger values[5]) {
+        BigInteger sum = parts[0] + parts[2];
+        values[0] = parts[0];
+        values[1] = sum + parts[1];
+        values[2] = sum - parts[1];
+        values[3] = (values[2] + parts[2]) * 2 - parts[0];
+        values[4] = parts[2];
+    };
+    BigInteger a_values[5], b_values[5];
+    Evaluate(a, a_values);
+    if (!square) {
+        Evaluate(b, b_values);
+    }
 
-        return result;
+    BigInteger r[5];
+    auto Product = [&](size_t i) {
+        r[i] = (square ? sqr(a_values[i]) : Multiplication(a_values[i], b_values[i]));
     };
+    if (IsParallel(k)) {
+        TaskPool::Group group(TaskPool::Global());
+        for (size_t i = 0; i < 4; ++i) {
+            group.Run([&Product, i] { Product(i); });
+        }
+        Product(4);
+        group.Wait();
+    } else {
+        for (size_t i = 0; i < 5; ++i) {
+            Product(i);
+        }
+    }
 
-    int base_length = std::max(lhs.getLength(), rhs.getLength()) / 2;
+    /// r = {r(0), r(1), r(-1), r(-2), r(inf)} -> coefficients c0..c4
+    BigInteger c0 = r[0];
+    BigInteger c4 = r[4];
+    BigInteger c3 = (r[3] - r[1]) / 3;
+    BigInteger c1 = (r[1] - r[2]) / 2;
+    BigInteger c2 = r[2] - r[0];
+    c3 = (c2 - c3) / 2 + c4 * 2;
+    c2 += c1 - c4;
+    c1 -= c3;
 
-    if (base_length <= 1) {
+    const size_t total = lhs.num_.size() + rhs.num_.size();
+    BigInteger result;
+    result.num_.assign(total, 0);
+    const BigInteger* coefficients[5] = {&c0, &c1, &c2, &c3, &c4};
+    for (size_t i = 0; i < 5 && i * k < total; ++i) {
+        const Limbs& limbs = coefficients[i]->num_;
+        const size_t len = std::min(limbs.size(), total - i * k);
+        AddTo(result.num_.data() + i * k, total - i * k, limbs.data(), len);
+    }
+    result.is_positive_ = (lhs.IsPositive() == rhs.IsPositive());
+    result.validate();
+    return result;
+}
+
+BigInteger BigInteger::NTTMultiplication(const BigInteger& lhs, const BigInteger& rhs) {
+    BIGINTEGER_OPERATION(NTT, lhs.num_.size() + rhs.num_.size());
+    BigInteger result;
+    result.num_.resize(lhs.num_.size() + rhs.num_.size());
+    NTT::Multiply(lhs.num_.data(), lhs.num_.size(), rhs.num_.data(), rhs.num_.size(),
+                  result.num_.data());
+    result.is_positive_ = (lhs.IsPositive() == rhs.IsPositive());
+    result.validate();
+    return result;
+}
+
+BigInteger BigInteger::Multiplication(const BigInteger& lhs, const BigInteger& rhs) {
+    if (&lhs == &rhs) {
+        return sqr(lhs);
+    }
+    BIGINTEGER_OPERATION(Multiply, lhs.num_.size() + rhs.num_.size());
+    const size_t shorter = std::min(lhs.num_.size(), rhs.num_.size());
+    const size_t longer = std::max(lhs.num_.size(), rhs.num_.size());
+    if (shorter <= multiplication_thresholds.karatsuba) {
         return NativeMultiplication(lhs, rhs);
     }
+    if (shorter >= multiplication_thresholds.ntt) {
+        return NTTMultiplication(lhs, rhs);
+    }
+    /// Toom-3 splits by the longer operand, so it pays off only for balanced ones
+    if (shorter >= multiplication_thresholds.toom3 && longer < 2 * shorter) {
+        return ToomCook3Multiplication(lhs, rhs);
+    }
+    return KaratsubaMultiplication(lhs, rhs);
+}
+
+void BigInteger::getUnsignedSquare(const Limb* number, size_t size, Limb* result) {
+    if (size <= multiplication_thresholds.karatsuba) {
+        SqrSchoolbook(number, size, result);
+    } else {
+        SqrKaratsuba(number, size, result, multiplication_thresholds.karatsuba);
+    }
+}
+
+BigInteger BigInteger::sqr(const BigInteger& number) {
+    BIGINTEGER_OPERATION(Square, number.num_.size());
+    const size_t size = number.num_.size();
+    if (size >= multiplication_thresholds.ntt) {
+        return NTTMultiplication(number, number);
+    }
+    if (size >= multiplication_thresholds.toom3) {
+        return ToomCook3Multiplication(number, number);
+    }
 
-    NumberDivision lhs_div = GetDivision(lhs, base_length),
-                   rhs_div = GetDivision(rhs, base_length);
-
-    /// Main algorithm
-    /// A = A0 + A1 * Base ^ M
-    /// B = B0 + B1 * Base ^ M
-    /// A * B = (A0 + A1 * Base ^ M) * (B0 + B1 * Base ^ M)
-    /// A * B = (A0 * B0) + (A0 * B1 + A1 * B0) * (Base ^ M) + (A1 * B1) * (Base ^ 2M)
-    /// A0 * B1 + A1 * B0 = (A0 + A1) * (B0 + B1) - A0 * B0 - A1 * B1
-    /// C0 = A0 * B0
-    /// C1 = A1 * B1
-    /// C2 = A0 * B1 + A1 * B0 = (A0 + A1) * (B0 + B1) - C0 - C1
-    /// A * B = C0 + C2 * Base ^ M + C1 * Base ^ 2M
-    BigInteger C0 = KaratsubaMultiplication(lhs_div.rhs, rhs_div.rhs);
-    BigInteger C1 = KaratsubaMultiplication(lhs_div.lhs, rhs_div.lhs);
-    BigInteger C2 = KaratsubaMultiplication(lhs_div.lhs + lhs_div.rhs, rhs_div.lhs + rhs_div.rhs) - C0 - C1;
-
-    int result_len = std::max(std::max(C0.getLength(), C2.getLength() + base_length),
-                              C1.getLength() + 2 * base_length);
-    std::vector<int> result(result_len, 0);
-
-    auto AddTo = [](std::vector<int>& result, std::vector<Digit>& number, int starting_pos) {
-        assert(result.size() >= number.size() + starting_pos);
-        for (int i = 0; i < number.size(); ++i) {
-            result[starting_pos + i] += static_cast<int>(number[i]);
+    BigInteger result;
+    result.num_.resize(2 * size);
+    getUnsignedSquare(number.num_.data(), size, result.num_.data());
+    result.validate();
+    return result;
+}
+
+BigInteger::MultiplicationThresholds BigInteger::GetMultiplicationThresholds() {
+    return multiplication_thresholds;
+}
+
+void BigInteger::SetMultiplicationThresholds(const MultiplicationThresholds& thresholds) {
+    multiplication_thresholds = thresholds;
+}
+
+BigInteger::MultiplicationThresholds BigInteger::TuneMultiplicationThresholds() {
+    const MultiplicationThresholds saved = multiplication_thresholds;
+    constexpr size_t kNever = std::numeric_limits<size_t>::max();
+    std::mt19937_64 generator(20210325);
+
+    auto Random = [&generator](size_t limbs) {
+        Limbs result(limbs);
+        for (auto& limb : result) {
+            limb = generator();
         }
+        result.back() |= Limb(1) << (kLimbBits - 1);
+        return BigInteger(std::move(result));
+    };
+    using Multiply = BigInteger (*)(const BigInteger&, const BigInteger&);
+    /// Time of one multiplication in seconds: the best of three rounds, 2 ms each
+    auto Measure = [](Multiply multiply, const BigInteger& lhs, const BigInteger& rhs) {
+        using Clock = std::chrono::steady_clock;
+        double best = std::numeric_limits<double>::max();
+        for (int round = 0; round < 3; ++round) {
+            const auto start = Clock::now();
+            size_t repeats = 0;
+            std::chrono::duration<double> elapsed{0};
+            do {
+                multiply(lhs, rhs);
+                ++repeats;
+                elapsed = Clock::now() - start;
+            } while (elapsed.count() < 0.002);
+            best = std::min(best, elapsed.count() / static_cast<double>(repeats));
+        }
+        return best;
+    };
+    /// Where the candidate starts to beat the baseline on operands of equal size
+    auto Crossover = [&](size_t from, size_t to, auto prepare, Multiply candidate, Multiply baseline) {
+        return findCrossover(from, to, [&](size_t size) {
+            prepare(size);
+            const BigInteger lhs = Random(size), rhs = Random(size);
+            return Measure(candidate, lhs, rhs) < Measure(baseline, lhs, rhs);
+        });
     };
-    AddTo(result, C0.num_, 0);
-    AddTo(result, C2.num_, base_length);
-    AddTo(result, C1.num_, 2 * base_length);
 
-    std::vector<Digit> byte_result;
-    byte_result.reserve(result.size());
-    int d = 0;
-    for (int i = 0; i < result.size() || d; ++i) {
-        int cur = (i < result.size() ? result[i] : 0) + d;
-        byte_result.push_back(cur % 10);
-        d = cur / 10;
-    }
+    /// Crossovers are measured in one thread, the parallel cutoff is kept as it is
+    MultiplicationThresholds result = saved;
+    multiplication_thresholds = {kNever, kNever, kNever, kNever};
 
-    BigInteger big_int_result{byte_result};
-    big_int_result.is_positive_ = (lhs.IsPositive() == rhs.IsPositive());
-    return big_int_result;
+    /// One level of Karatsuba over schoolbook halves against schoolbook
+    const size_t karatsuba = Crossover(
+            8, 256, [](size_t size) { multiplication_thresholds.karatsuba = size - 1; },
+            KaratsubaMultiplication, NativeMultiplication);
+    result.karatsuba = (karatsuba == kNever ? 256 : karatsuba - 1);
+    multiplication_thresholds.karatsuba = result.karatsuba;
+
+    /// One level of Toom-3 over Karatsuba against Karatsuba
+    result.toom3 = Crossover(2 * result.karatsuba, 4096, [](size_t) {},
+                             ToomCook3Multiplication, KaratsubaMultiplication);
+    multiplication_thresholds.toom3 = result.toom3;
+
+    /// The transform against everything below it
+    result.ntt = Crossover(2 * result.karatsuba, 65536, [](size_t) {},
+                           NTTMultiplication, Multiplication);
+
+    multiplication_thresholds = saved;
+    return result;
 }
 
 std::ostream& operator << (std::ostream& fout, const BigInteger& number) {
-    if (!number.IsPositive()) {
-        fout << "-";
-    }
-    for (int i = (int)number.data().size() - 1; i >= 0; --i) {
-        int digit = static_cast<int>(number.data()[i]);
-        fout << digit;
-    }
-    return fout;
+    return fout << number.ToString();
 }
 
 BigInteger BigInteger::abs(BigInteger number) {
@@ -650,82 +1570,288 @@ BigInteger BigInteger::abs(BigInteger number) {
 }
 
 BigInteger BigInteger::sqrt(const BigInteger& number) {
-    if (number == BigInteger::zero()) {
-        return number;
+    return isqrt(number);
+}
+
+BigInteger BigInteger::isqrt(const BigInteger& number) {
+    assert(number.IsPositive());
+    if (number.num_.size() <= 2) {
+        unsigned __int128 value = number.num_[0];
+        if (number.num_.size() == 2) {
+            value |= (unsigned __int128)number.num_[1] << kLimbBits;
+        }
+        /// The estimate may round up to 2^64, which doesn't fit into a limb
+        const long double estimate = std::sqrt(static_cast<long double>(value));
+        Limb root = (estimate >= 0x1p64L ? std::numeric_limits<Limb>::max() : static_cast<Limb>(estimate));
+        while ((unsigned __int128)root * root > value) {
+            --root;
+        }
+        while (root != std::numeric_limits<Limb>::max() &&
+               (unsigned __int128)(root + 1) * (root + 1) <= value) {
+            ++root;
+        }
+        return BigInteger(Limbs(1, root));
+    }
+
+    /// Precision doubling: the root of the upper half of bits gives the upper
+    /// quarter of bits of the answer, x = (isqrt(number >> 2k) + 1) << k is not less
+    /// than the answer, and a couple of Newton's steps x = (x + number / x) / 2 finish it
+    const size_t shift = number.bit_length() / 4;
+    BigInteger upper = number;
+    ShiftRight(upper.num_, 2 * shift);
+    BigInteger x = isqrt(upper) + 1;
+    ShiftLeft(x.num_, shift);
+
+    BigInteger quotient, remainder;
+    while (true) {
+        divmod(number, x, quotient, remainder);
+        quotient += x;
+        ShiftRight(quotient.num_, 1);
+        if (quotient >= x) {
+            return x;
+        }
+        std::swap(x, quotient);
+    }
+}
+
+bool BigInteger::is_perfect_square(const BigInteger& number) {
+    if (!number.IsPositive()) {
+        return false;
     }
-    long long len = ((long long)number.num_.size() + 1) / 2;
-    std::vector<Digit> result(len, 0);
-    for (long long i = len - 1; i >= 0; --i) {
-        Digit l = 0;
-        Digit r = 9;
-        while (l < r) {
-            Digit mid = (l + r + 1) / 2;
-            result[i] = mid;
-            BigInteger w(result);
-            if ((w * w) <= number) l = mid;
-            else r = mid - 1;
+
+    /// Squares modulo 64, 63, 65 and 11 reject all but about 1.5% of non-squares
+    /// before the root is computed
+    struct ResidueFilter {
+        explicit ResidueFilter(Limb modulus) : is_square(modulus, false) {
+            for (Limb i = 0; i < modulus; ++i) {
+                is_square[i * i % modulus] = true;
+            }
         }
-        result[i] = l;
+        std::vector<bool> is_square;
+    };
+    static const ResidueFilter mod64(64), mod63(63), mod65(65), mod11(11);
+
+    if (!mod64.is_square[number.num_[0] % 64]) {
+        return false;
+    }
+    const Limb residue = ModSmall(number.num_, 63 * 65 * 11);
+    if (!mod63.is_square[residue % 63] || !mod65.is_square[residue % 65] ||
+        !mod11.is_square[residue % 11]) {
+        return false;
     }
-    BigInteger w(result);
-    w.validate();
-    return w;
+    return sqr(isqrt(number)) == number;
 }
 
 BigInteger BigInteger::mod(const BigInteger& lhs, const BigInteger& rhs) {
+    BigInteger remainder;
+    divide(lhs, rhs, nullptr, &remainder);
+    if (remainder != zero() && lhs.IsPositive() != rhs.IsPositive()) {
+        remainder += rhs;
+    }
+    return remainder;
+}
+
+BigInteger BigInteger::mod(BigInteger&& lhs, const BigInteger& rhs) {
+    const bool is_shifted = (lhs.IsPositive() != rhs.IsPositive());
+    divide(lhs, rhs, nullptr, &lhs);
+    if (lhs != zero() && is_shifted) {
+        lhs += rhs;
+    }
+    return std::move(lhs);
+}
+
+void BigInteger::divmod(const BigInteger& lhs, const BigInteger& rhs,
+                        BigInteger& quotient, BigInteger& remainder) {
+    divide(lhs, rhs, &quotient, &remainder);
+}
+
+void BigInteger::divide(const BigInteger& lhs, const BigInteger& rhs,
+                        BigInteger* quotient, BigInteger* remainder) {
     if (rhs == zero()) {
         exit(1);
     }
-    if (lhs == zero()) {
-        return zero();
+    const bool quotient_sign = (lhs.IsPositive() == rhs.IsPositive());
+    const bool remainder_sign = lhs.IsPositive();
+
+    getUnsignedDivision(lhs.num_, rhs.num_, quotient ? &quotient->num_ : nullptr,
+                        remainder ? &remainder->num_ : nullptr);
+
+    if (quotient) {
+        quotient->is_positive_ = quotient_sign;
+        quotient->validate();
     }
-    BigInteger floorDiv = lhs / rhs;
-    if (lhs.IsPositive() != rhs.IsPositive()) {
-        if (lhs % rhs != zero()) {
-            floorDiv = floorDiv - 1;
-        }
+    if (remainder) {
+        remainder->is_positive_ = remainder_sign;
+        remainder->validate();
     }
-    BigInteger result = lhs - (rhs * floorDiv);
-    return result;
 }
 
 BigInteger BigInteger::gcd(BigInteger lhs, BigInteger rhs) {
+    BIGINTEGER_OPERATION(Gcd, lhs.num_.size() + rhs.num_.size());
     lhs.is_positive_ = true;
     rhs.is_positive_ = true;
-    while (lhs > 0 && rhs > 0) {
-        if (lhs > rhs) {
-            lhs = mod(lhs, rhs);
+    if (lhs == zero() || rhs == zero()) {
+        return lhs + rhs;
+    }
+    if (std::max(lhs.num_.size(), rhs.num_.size()) <= kBinaryGcdThreshold) {
+        return BigInteger(getBinaryGcd(std::move(lhs.num_), std::move(rhs.num_)));
+    }
+    return BigInteger(getLehmerGcd(std::move(lhs.num_), std::move(rhs.num_)));
+}
+
+BigInteger::Limbs BigInteger::getBinaryGcd(Limbs lhs, Limbs rhs) {
+    /// Stein's algorithm: strip the common power of two,
+    /// then subtract the smaller odd number from the bigger one
+    const size_t lhs_zeros = CountTrailingZeros(lhs);
+    const size_t rhs_zeros = CountTrailingZeros(rhs);
+    ShiftRight(lhs, lhs_zeros);
+    ShiftRight(rhs, rhs_zeros);
+    while (lhs.size() > 1 || rhs.size() > 1) {
+        if (compareUnsignedNumbers(lhs, rhs) == CompareSign::GREATER) {
+            lhs.swap(rhs);
+        }
+        SubtractFrom(rhs.data(), rhs.size(), lhs.data(), lhs.size());
+        while (rhs.size() > 1 && rhs.back() == 0) {
+            rhs.pop_back();
+        }
+        if (rhs.size() == 1 && rhs[0] == 0) {
+            break;
+        }
+        ShiftRight(rhs, CountTrailingZeros(rhs));
+    }
+    if (lhs.size() == 1 && rhs.size() == 1) {
+        lhs[0] = BinaryGcd(lhs[0], rhs[0]);
+    }
+    ShiftLeft(lhs, std::min(lhs_zeros, rhs_zeros));
+    return lhs;
+}
+
+BigInteger::Limbs BigInteger::getLehmerGcd(Limbs lhs, Limbs rhs) {
+    if (compareUnsignedNumbers(lhs, rhs) == CompareSign::LESS) {
+        lhs.swap(rhs);
+    }
+
+    Limbs next_lhs, next_rhs;
+    while (rhs.size() > 1) {
+        const LehmerMatrix m = GetLehmerMatrix(lhs, rhs);
+        if (m.b == 0) {
+            /// The leading bits give nothing, make one ordinary Euclid's step
+            getUnsignedDivision(lhs, rhs, nullptr, &next_rhs);
+            while (next_rhs.size() > 1 && next_rhs.back() == 0) {
+                next_rhs.pop_back();
+            }
+            lhs.swap(rhs);
+            rhs.swap(next_rhs);
         } else {
-            rhs = mod(rhs, lhs);
+            LinearCombination(lhs, rhs, m.a, m.b, next_lhs);
+            LinearCombination(lhs, rhs, m.c, m.d, next_rhs);
+            lhs.swap(next_lhs);
+            rhs.swap(next_rhs);
         }
     }
-    return lhs + rhs;
+
+    if (rhs[0] == 0) {
+        return lhs;
+    }
+    const Limb remainder = DivideBySmall(lhs, rhs[0]);
+    rhs[0] = BinaryGcd(rhs[0], remainder);
+    return rhs;
+}
+
+BigInteger BigInteger::getGcdCofactor(const BigInteger& lhs, const BigInteger& rhs,
+                                      BigInteger& x) {
+    BIGINTEGER_OPERATION(Gcd, lhs.num_.size() + rhs.num_.size());
+    /// Invariants: a = s * |lhs| (mod |rhs|), b = t * |lhs| (mod |rhs|)
+    BigInteger a = abs(lhs), b = abs(rhs);
+    BigInteger s = 1, t = 0;
+    if (a < b) {
+        std::swap(a, b);
+        std::swap(s, t);
+    }
+
+    BigInteger quotient, remainder;
+    Limbs next_a, next_b;
+    while (b != zero()) {
+        if (b.num_.size() > 1) {
+            const LehmerMatrix m = GetLehmerMatrix(a.num_, b.num_);
+            if (m.b != 0) {
+                LinearCombination(a.num_, b.num_, m.a, m.b, next_a);
+                LinearCombination(a.num_, b.num_, m.c, m.d, next_b);
+                a.num_.swap(next_a);
+                b.num_.swap(next_b);
+                BigInteger next_s = s * static_cast<long long>(m.a) + t * static_cast<long long>(m.b);
+                t = s * static_cast<long long>(m.c) + t * static_cast<long long>(m.d);
+                s = std::move(next_s);
+                continue;
+            }
+        }
+        divmod(a, b, quotient, remainder);
+        std::swap(a, b);
+        b = std::move(remainder);
+        s -= quotient * t;
+        std::swap(s, t);
+    }
+
+    x = (lhs.IsPositive() ? std::move(s) : s * -1);
+    return a;
+}
+
+BigInteger BigInteger::ext_gcd(const BigInteger& lhs, const BigInteger& rhs,
+                               BigInteger& x, BigInteger& y) {
+    BigInteger g = getGcdCofactor(lhs, rhs, x);
+    y = (rhs == zero() ? zero() : (g - lhs * x) / rhs);
+    return g;
+}
+
+std::optional<BigInteger> BigInteger::inverse_mod(const BigInteger& number, const BigInteger& modulus) {
+    assert(modulus > 0);
+    BigInteger x;
+    if (getGcdCofactor(mod(number, modulus), modulus, x) != 1) {
+        return std::nullopt;
+    }
+    return mod(x, modulus);
+}
+
+std::optional<std::vector<BigInteger>> BigInteger::batch_inverse_mod(
+        const std::vector<BigInteger>& numbers, const BigInteger& modulus) {
+    assert(modulus > 0);
+    if (numbers.empty()) {
+        return std::vector<BigInteger>();
+    }
+
+    /// Montgomery's trick: invert the product of all numbers once,
+    /// then peel the inverses off with the prefix products
+    BarrettReducer reducer(modulus);
+    std::vector<BigInteger> result(numbers.size());
+    result[0] = mod(numbers[0], modulus);
+    for (size_t i = 1; i < numbers.size(); ++i) {
+        result[i] = reducer.mulmod(result[i - 1], mod(numbers[i], modulus));
+    }
+
+    std::optional<BigInteger> inverse = inverse_mod(result.back(), modulus);
+    if (!inverse) {
+        return std::nullopt;
+    }
+    for (size_t i = numbers.size() - 1; i > 0; --i) {
+        result[i] = reducer.mulmod(*inverse, result[i - 1]);
+        *inverse = reducer.mulmod(*inverse, mod(numbers[i], modulus));
+    }
+    result[0] = std::move(*inverse);
+    return result;
 }
 
 BigInteger BigInteger::lcm(const BigInteger &lhs, const BigInteger &rhs) {
     assert(lhs > 0);
     assert(rhs > 0);
-    return (lhs * rhs) / gcd(lhs, rhs);
+    return (lhs / gcd(lhs, rhs)) * rhs;
 }
 
 int BigInteger::ToInt() const {
-    int result = 0;
-    for (int i = (int)num_.size(); i > 0; --i) {
-        result *= 10;
-        result += num_[i - 1];
-    }
-    if (!IsPositive()) {
-        result *= -1;
-    }
-    return result;
+    return static_cast<int>(ToLong());
 }
 
 long long BigInteger::ToLong() const {
-    long long result = 0;
-    for (int i = (int)num_.size(); i > 0; --i) {
-        result *= 10;
-        result += num_[i - 1];
-    }
+    long long result = static_cast<long long>(num_[0]);
     if (!IsPositive()) {
         result *= -1;
     }
@@ -733,113 +1859,178 @@ long long BigInteger::ToLong() const {
 }
 
 std::string BigInteger::ToString() const {
+    BIGINTEGER_OPERATION(Convert, num_.size());
     std::string result;
     if (!IsPositive()) {
         result += "-";
     }
-    for (int i = (int)num_.size(); i > 0; --i) {
-        result += static_cast<char>('0' + num_[i - 1]);
-    }
+    appendDecimal(num_, 0, result);
     return result;
 }
 
 std::string BigInteger::GetBase2() const {
-    BigInteger tmp = *this;
-    if (!tmp.IsPositive()) {
-        tmp.is_positive_ = true;
-    }
-    std::string result;
-    while (tmp > 0) {
-        auto r = tmp % 2;
-        result += (r == 0 ? '0' : '1');
-        tmp /= 2;
-    }
-    std::reverse(result.begin(), result.end());
-    if (result.empty()) {
-        result = "0";
-    }
-    return result;
+    BIGINTEGER_OPERATION(Convert, num_.size());
+    return ToPowerOfTwoBase(num_, bit_length(), 1, [](unsigned int x) {
+        return static_cast<char>('0' + x);
+    });
 }
 
 std::string BigInteger::GetHex() const {
-    BigInteger tmp = *this;
-    if (!tmp.IsPositive()) {
-        tmp.is_positive_ = true;
-    }
-    std::string result;
-    while (tmp > 0) {
-        auto r = tmp % 16;
-        result += ToHex(r.ToInt());
-        tmp /= 16;
-    }
-    std::reverse(result.begin(), result.end());
-    if (result.empty()) {
-        result += ToHex(0);
-    }
-    return result;
+    BIGINTEGER_OPERATION(Convert, num_.size());
+    return ToPowerOfTwoBase(num_, bit_length(), 4, ToHex);
 }
 
 std::string BigInteger::GetBase64() const {
-    BigInteger tmp = *this;
-    if (!tmp.IsPositive()) {
-        tmp.is_positive_ = true;
-    }
-    std::string result;
-    while (tmp > 0) {
-        auto r = tmp % 64;
-        result += ToBase64(r.ToInt());
-        tmp /= 64;
-    }
-    std::reverse(result.begin(), result.end());
-    if (result.empty()) {
-        result += ToBase64(0);
-    }
-    return result;
+    BIGINTEGER_OPERATION(Convert, num_.size());
+    return ToPowerOfTwoBase(num_, bit_length(), 6, ToBase64);
 }
 
 std::string BigInteger::GetByte() const {
-    BigInteger tmp = *this;
-    if (!tmp.IsPositive()) {
-        tmp.is_positive_ = true;
-    }
+    BIGINTEGER_OPERATION(Convert, num_.size());
+    std::string result(std::max<size_t>(byte_length(), 1), '\0');
+    export_bytes(reinterpret_cast<uint8_t*>(&result[0]), result.size(), ByteOrder::BigEndian);
+    return result;
+}
 
-    std::string result;
-    while (tmp > 0) {
-        auto r = tmp % 256;
-        result += static_cast<unsigned char>(r.ToInt());
-        tmp /= 256;
+BigInteger BigInteger::GetFromBase2(const std::string& src) {
+    BIGINTEGER_OPERATION(Convert, LimbsForDigits(src.size(), 1000));
+    return BigInteger(FromPowerOfTwoBase(src, 1, [](char c) {
+        return static_cast<Limb>(c - '0');
+    }));
+}
+
+BigInteger BigInteger::GetFromBase64(const std::string& src) {
+    BIGINTEGER_OPERATION(Convert, LimbsForDigits(src.size(), 6000));
+    return BigInteger(FromPowerOfTwoBase(src, 6, FromBase64));
+}
+
+BigInteger BigInteger::GetFromByte(const std::string& src) {
+    BIGINTEGER_OPERATION(Convert, LimbsForDigits(src.size(), 8000));
+    return import_bytes(reinterpret_cast<const uint8_t*>(src.data()), src.size(), ByteOrder::BigEndian);
+}
+
+size_t BigInteger::byte_length() const {
+    return (bit_length() + 7) / 8;
+}
+
+void BigInteger::export_bytes(uint8_t* out, size_t size, ByteOrder order) const {
+    assert(size >= byte_length());
+    for (size_t i = 0; i < size; ++i) {
+        const size_t index = i / sizeof(Limb);
+        const uint8_t byte = (index < num_.size() ? static_cast<uint8_t>(num_[index] >> (8 * (i % sizeof(Limb)))) : 0);
+        out[order == ByteOrder::LittleEndian ? i : size - 1 - i] = byte;
     }
-    std::reverse(result.begin(), result.end());
+}
 
-    if (result.empty()) {
-        result += static_cast<unsigned char>(0);
+BigInteger BigInteger::import_bytes(const uint8_t* data, size_t size, ByteOrder order) {
+    Limbs limbs(std::max<size_t>((size + sizeof(Limb) - 1) / sizeof(Limb), 1), 0);
+    for (size_t i = 0; i < size; ++i) {
+        const Limb byte = data[order == ByteOrder::LittleEndian ? i : size - 1 - i];
+        limbs[i / sizeof(Limb)] |= byte << (8 * (i % sizeof(Limb)));
     }
-    return result;
+    return BigInteger(std::move(limbs));
 }
 
-BigInteger BigInteger::GetFromBase2(const std::string& src) {
-    BigInteger result = 0;
-    for (auto c : src) {
-        result *= 2;
-        result += c - '0';
+size_t BigInteger::serialized_size() const {
+    return kHeaderSize + byte_length();
+}
+
+size_t BigInteger::write_to(uint8_t* out, ByteOrder order) const {
+    const size_t length = byte_length();
+    assert(length < kNegativeFlag);
+    const uint32_t header = static_cast<uint32_t>(length) | (IsPositive() ? 0 : kNegativeFlag);
+    for (size_t i = 0; i < kHeaderSize; ++i) {
+        out[order == ByteOrder::LittleEndian ? i : kHeaderSize - 1 - i] = static_cast<uint8_t>(header >> (8 * i));
     }
-    return result;
+    export_bytes(out + kHeaderSize, length, order);
+    return kHeaderSize + length;
 }
 
-BigInteger BigInteger::GetFromBase64(const std::string& src) {
-    BigInteger result = 0;
-    for (auto c : src) {
-        result *= 64;
-        result += FromBase64(c);
+std::optional<BigInteger> BigInteger::read_from(const uint8_t* data, size_t size, size_t& read,
+                                                ByteOrder order) {
+    if (size < kHeaderSize) {
+        return std::nullopt;
+    }
+    uint32_t header = 0;
+    for (size_t i = 0; i < kHeaderSize; ++i) {
+        header |= uint32_t(data[order == ByteOrder::LittleEndian ? i : kHeaderSize - 1 - i]) << (8 * i);
     }
+    const size_t length = header & ~kNegativeFlag;
+    if (size - kHeaderSize < length) {
+        return std::nullopt;
+    }
+
+    BigInteger result = import_bytes(data + kHeaderSize, length, order);
+    result.is_positive_ = !(header & kNegativeFlag);
+    result.validateSign();
+    read = kHeaderSize + length;
     return result;
 }
 
-BigInteger BigInteger::GetFromByte(const std::string& src) {
-    BigInteger result = 0;
-    for (unsigned char c : src) {
-        result *= 256;
-        result += static_cast<int>(c);
+void BigInteger::appendDecimal(const Limbs& number, size_t width, std::string& result) {
+    if (number.size() <= kDecimalConversionThreshold) {
+        /// Split the number into base 10^19 chunks, each of them is printed separately
+        Limbs tmp = number;
+        std::vector<Limb> chunks;
+        chunks.reserve(tmp.size() * 2);
+        do {
+            chunks.push_back(DivideBySmall(tmp, kDecimalBase));
+        } while (tmp.size() > 1 || tmp[0] != 0);
+
+        const std::string head = std::to_string(chunks.back());
+        const size_t length = head.size() + (chunks.size() - 1) * kDecimalBaseDigits;
+        if (width > length) {
+            result.append(width - length, '0');
+        }
+        result += head;
+        for (auto i = chunks.size() - 1; i > 0; --i) {
+            std::string chunk = std::to_string(chunks[i - 1]);
+            result.append(kDecimalBaseDigits - chunk.size(), '0');
+            result += chunk;
+        }
+        return;
     }
-    return result;
+
+    /// number = high * 10^low_width + low, the power takes about a half of the limbs
+    size_t k = 0;
+    while (2 * DecimalPower(k + 1).num_.size() <= number.size() + 1) {
+        ++k;
+    }
+    const size_t low_width = static_cast<size_t>(kDecimalBaseDigits) << k;
+    BigInteger high, low;
+    getUnsignedDivision(number, DecimalPower(k).num_, &high.num_, &low.num_);
+    high.validate();
+    low.validate();
+    appendDecimal(high.num_, (width > low_width ? width - low_width : 0), result);
+    appendDecimal(low.num_, low_width, result);
+}
+
+BigInteger::Limbs BigInteger::parseDecimal(const char* begin, const char* end) {
+    const size_t length = end - begin;
+    if (length <= kDecimalBaseDigits * kDecimalConversionThreshold) {
+        Limbs result = {0};
+        result.reserve(length / kDecimalBaseDigits + 1);
+        for (const char* it = begin; it != end; ) {
+            Limb chunk = 0;
+            Limb chunk_base = 1;
+            for (int j = 0; j < kDecimalBaseDigits && it != end; ++j, ++it) {
+                assert('0' <= *it && *it <= '9');
+                chunk = chunk * 10 + (*it - '0');
+                chunk_base *= 10;
+            }
+            MulAddSmall(result, chunk_base, chunk);
+        }
+        return result;
+    }
+
+    /// The lower part has 19 * 2^k digits, which is at least a half of them
+    size_t k = 0;
+    while ((static_cast<size_t>(kDecimalBaseDigits) << (k + 1)) < length) {
+        ++k;
+    }
+    const size_t low_width = static_cast<size_t>(kDecimalBaseDigits) << k;
+    BigInteger result(parseDecimal(begin, end - low_width));
+    result *= DecimalPower(k);
+    result += BigInteger(parseDecimal(end - low_width, end));
+    return std::move(result.num_);
 }
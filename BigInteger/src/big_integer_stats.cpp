@@ -0,0 +1,114 @@
+#include "big_integer_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace {
+    using namespace BigIntegerStats;
+
+    struct AtomicCounter {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> limbs{0};
+    };
+
+    /// Written only by the owning thread, so an increment is a plain load and store,
+    /// atomics just let snapshots read them from other threads
+    void Increment(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    struct ThreadCounters {
+        ThreadCounters();
+        ~ThreadCounters();
+
+        std::array<AtomicCounter, kOperations> operations;
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> allocated_bytes{0};
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadCounters*> threads;
+        /// Counters of the threads which have already exited
+        Snapshot finished;
+    };
+
+    /// Never destroyed: thread-local counters may outlive static objects
+    Registry& GetRegistry() {
+        static Registry* registry = new Registry();
+        return *registry;
+    }
+
+    ThreadCounters& Local() {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+
+    void AddTo(Snapshot& snapshot, const ThreadCounters& counters) {
+        for (size_t i = 0; i < kOperations; ++i) {
+            snapshot.operations[i].calls += counters.operations[i].calls.load(std::memory_order_relaxed);
+            snapshot.operations[i].limbs += counters.operations[i].limbs.load(std::memory_order_relaxed);
+        }
+        snapshot.allocations += counters.allocations.load(std::memory_order_relaxed);
+        snapshot.allocated_bytes += counters.allocated_bytes.load(std::memory_order_relaxed);
+    }
+
+    ThreadCounters::ThreadCounters() {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.push_back(this);
+    }
+
+    ThreadCounters::~ThreadCounters() {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        AddTo(registry.finished, *this);
+        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+    }
+}  // namespace
+
+const char* BigIntegerStats::GetName(Operation operation) {
+    static const char* const kNames[kOperations] = {
+        "multiply", "schoolbook", "karatsuba", "toom_cook3", "ntt",
+        "square", "divide", "pow", "gcd", "convert",
+    };
+    return kNames[static_cast<size_t>(operation)];
+}
+
+BigIntegerStats::Snapshot BigIntegerStats::GetSnapshot() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    Snapshot snapshot = registry.finished;
+    for (const ThreadCounters* counters : registry.threads) {
+        AddTo(snapshot, *counters);
+    }
+    return snapshot;
+}
+
+void BigIntegerStats::Reset() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.finished = Snapshot();
+    for (ThreadCounters* counters : registry.threads) {
+        for (auto& counter : counters->operations) {
+            counter.calls.store(0, std::memory_order_relaxed);
+            counter.limbs.store(0, std::memory_order_relaxed);
+        }
+        counters->allocations.store(0, std::memory_order_relaxed);
+        counters->allocated_bytes.store(0, std::memory_order_relaxed);
+    }
+}
+
+void BigIntegerStats::Count(Operation operation, size_t limbs) {
+    AtomicCounter& counter = Local().operations[static_cast<size_t>(operation)];
+    Increment(counter.calls, 1);
+    Increment(counter.limbs, limbs);
+}
+
+void BigIntegerStats::CountAllocation(size_t bytes) {
+    ThreadCounters& counters = Local();
+    Increment(counters.allocations, 1);
+    Increment(counters.allocated_bytes, bytes);
+}
@@ -1,39 +1,10 @@
 #include "chinese_remainder_theorem.h"
 
-namespace {
-    BigInteger gcd(const BigInteger& a, const BigInteger& b, BigInteger& x, BigInteger& y) {
-        if (a == BigInteger::zero()) {
-            x = BigInteger::zero();
-            y = BigInteger(1);
-            return b;
-        }
-        BigInteger xx, yy;
-        BigInteger d = gcd(b % a, a, xx, yy);
-        x = yy - (b / a) * xx;
-        y = xx;
-        return d;
-    }
-
-    BigInteger inverseMod(const BigInteger& number, const BigInteger& md) {
-        if (number < BigInteger::zero() || md < BigInteger::zero()) {
-            exit(1);
-        }
-        BigInteger x, y;
-        BigInteger g = gcd(number, md, x, y);
-        if (g != BigInteger(1)) {
-            exit(1);
-        }
-        x = (x % md + md) % md;
-        return x;
-    }
-}  // namespace
-
 void CRT_Solver::add_equation(BigInteger new_a,
                               BigInteger new_b,
                               BigInteger new_p) {
     {
-        BigInteger x, y;
-        BigInteger g = gcd(new_a, new_p, x, y);
+        BigInteger g = BigInteger::gcd(new_a, new_p);
         if (new_b % g != BigInteger::zero()) {
             exit(1);
         }
@@ -41,7 +12,7 @@ void CRT_Solver::add_equation(BigInteger new_a,
         new_b /= g;
         new_p /= g;
     }
-    BigInteger b = (new_b * inverseMod(new_a, new_p)) % new_p;
+    BigInteger b = (new_b * *BigInteger::inverse_mod(new_a, new_p)) % new_p;
     equations.emplace_back(std::make_pair(b, new_p));
     delete answer;
     answer = nullptr;
@@ -68,8 +39,7 @@ BigInteger* CRT_Solver::solve() {
     BigInteger total_mod(1);
 
     for (int i = 0; i < n; ++i) {
-        BigInteger x, y;
-        BigInteger g = gcd(total_mod, equations[i].second, x, y);
+        BigInteger g = BigInteger::gcd(total_mod, equations[i].second);
         total_mod *= equations[i].second;
         total_mod /= g;
     }
@@ -83,14 +53,13 @@ BigInteger* CRT_Solver::solve() {
             BigInteger bb = equations[j].first;
             bb = (pp + bb - (b % pp)) % pp;
             {
-                BigInteger x, y;
-                BigInteger g = gcd(p, pp, x, y);
+                BigInteger g = BigInteger::gcd(p, pp);
                 if (bb % g != BigInteger::zero()) {
                     return answer = nullptr;
                 }
                 bb /= g;
                 pp /= g;
-                bb *= inverseMod(p / g, pp);
+                bb *= *BigInteger::inverse_mod(p / g, pp);
                 bb %= pp;
             }
             equations[j] = std::make_pair(bb, pp);
@@ -2,35 +2,43 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <optional>
 #include <random>
-#include <sys/time.h>
 
 #include "crypto_algorithms.h"
+#include "barrett.h"
+#include "montgomery.h"
+#include "random_generator.h"
+#include "task_pool.h"
 
 namespace {
 
     using fp2 = std::pair<BigInteger, BigInteger>;
 
-    fp2 fp2mul(fp2 a, fp2 b, BigInteger p, BigInteger w2) {
+    fp2 fp2mul(const fp2& a, const fp2& b, const BarrettReducer& p, const BigInteger& w2) {
         fp2 answer;
         BigInteger tmp1, tmp2;
      
-        tmp1 = (a.first * b.first) % p;
-        tmp2 = (a.second * b.second) % p;
-        tmp2 = (tmp2 * w2) % p;
-        answer.first = (tmp1 + tmp2) % p;
-        tmp1 = (a.first * b.second) % p;
-        tmp2 = (a.second * b.first) % p;
-        answer.second = (tmp1 + tmp2) % p;
+        tmp1 = p.mulmod(a.first, b.first);
+        tmp2 = p.mulmod(a.second, b.second);
+        tmp2 = p.mulmod(tmp2, w2);
+        answer.first = p.reduce(tmp1 + tmp2);
+        tmp1 = p.mulmod(a.first, b.second);
+        tmp2 = p.mulmod(a.second, b.first);
+        answer.second = p.reduce(tmp1 + tmp2);
         
         return answer;
     }
 
-    fp2 fp2square(fp2 a, BigInteger p, BigInteger w2) {
-        return fp2mul(a, a, p, w2);
+    /// (a + b * w) ^ 2 = (a ^ 2 + b ^ 2 * w2) + 2ab * w
+    fp2 fp2square(const fp2& a, const BarrettReducer& p, const BigInteger& w2) {
+        fp2 answer;
+        answer.first = p.reduce(p.sqrmod(a.first) + p.mulmod(p.sqrmod(a.second), w2));
+        answer.second = p.reduce(p.mulmod(a.first, a.second) * 2);
+        return answer;
     }
      
-    fp2 fp2pow(fp2 a, BigInteger n, BigInteger p, BigInteger w2) {
+    fp2 fp2pow(const fp2& a, const BigInteger& n, const BarrettReducer& p, const BigInteger& w2) {
         fp2 ret;
      
         if (n == 0) {
@@ -51,51 +59,29 @@ namespace {
 }  // namespace
 
 void Crypto::RandomSeedInitialization() {
-//    timeval time;
-  //  gettimeofday(&time, nullptr);
-    //std::srand((time.tv_sec * 1000) + (time.tv_usec / 1000));
-    unsigned int time_ui = static_cast<unsigned int>(time(nullptr));
-    srand( time_ui );
+    RandomGenerator::ForThread() = RandomGenerator();
 }
 
 BigInteger Crypto::GetRandomNumber(const BigInteger& max_value) {
-    const size_t max_length = max_value.getLength();
-    
-    BigInteger result = 0;
-    bool is_smaller = false;
-    for (int i = 1; i <= max_length; ++i) {
-        if (is_smaller) {
-            int new_digit = rand() % 10;
-            result = (result * 10) + new_digit;
-        } else {
-            int cur_digit = max_value.getDigitAt(i);
-            int new_digit = rand() % (cur_digit + 1);
-            
-            result = (result * 10) + new_digit;
-            is_smaller |= (new_digit < cur_digit);
-        }
-    }
-    return result;
+    return RandomGenerator::ForThread().GetNumber(max_value);
 }
 
 BigInteger Crypto::GetRandomNumber(const BigInteger& min_value, const BigInteger& max_value) {
-    BigInteger diff = max_value - min_value + 1;
-    return min_value + GetRandomNumber(diff) - 1;
+    return RandomGenerator::ForThread().GetNumber(min_value, max_value);
+}
+
+std::vector<BigInteger> Crypto::GetRandomNumbers(const BigInteger& min_value, const BigInteger& max_value,
+                                                 size_t count) {
+    return RandomGenerator::ForThread().GetNumbers(min_value, max_value, count);
 }
 
 BigInteger Crypto::GetRandomNumberLen(int len) {
-    BigInteger max_limit;
-    for (int i = 1; i <= len; ++i) {
-        max_limit *= 10;
-        max_limit += 9;
-    }
+    const BigInteger max_limit = BigInteger::pow(10, len) - 1;
     return GetRandomNumber((max_limit + 1) / 10, max_limit);
 }
 
 BigInteger Crypto::GetRandomNumberWithBitness(int bitness) {
-    BigInteger lhs = BigInteger::pow(2, bitness - 1);
-    BigInteger rhs = BigInteger::pow(2, bitness) - 1;
-    return GetRandomNumber(lhs, rhs);
+    return RandomGenerator::ForThread().GetNumberWithBitness(bitness);
 }
 
 BigInteger Crypto::GetClosestPrimeNumber(const BigInteger& src) {
@@ -127,22 +113,32 @@ std::vector<BigInteger> Crypto::GetRandomPrimeNumbers(const BigInteger& lhs, con
         return result;
     }
 
-    for (int i = 0; i < k; ++i) {
-        bool found = false;
-        for (int j = 0; j < 10; ++j) {
-            BigInteger cur = GetRandomNumber(lhs, rhs);
-            cur = GetClosestPrimeNumber(cur);
-            if (cur <= rhs) {
-                found = true;
-                result.push_back(cur);
-                break;
-            }
+    /// The searches are independent, every one of them runs on its own thread
+    /// with the generator of that thread, the first candidates are drawn at once
+    std::vector<BigInteger> candidates = GetRandomNumbers(lhs, rhs, k);
+    std::vector<std::optional<BigInteger>> primes(k);
+    {
+        TaskPool::Group group(TaskPool::Global());
+        for (int i = 0; i < k; ++i) {
+            group.Run([&, i] {
+                for (int j = 0; j < 10; ++j) {
+                    BigInteger cur = GetClosestPrimeNumber(j == 0 ? candidates[i] : GetRandomNumber(lhs, rhs));
+                    if (cur <= rhs) {
+                        primes[i] = std::move(cur);
+                        return;
+                    }
+                }
+            });
         }
-        if (!found) {
+    }
+
+    for (auto& prime : primes) {
+        if (!prime) {
             result.shrink_to_fit();
             // TODO: Add c-error message
             break;
         }
+        result.push_back(std::move(*prime));
     }
     return result;
 }
@@ -165,8 +161,8 @@ std::vector<BigInteger> Crypto::GetRandomPrimeNumbersWithSomeBitness(int bitness
     if (bitness == 1) {
         return {};
     }
-    BigInteger lhs = BigInteger::pow(2, bitness - 1);
-    BigInteger rhs = BigInteger::pow(2, bitness) - 1;
+    BigInteger lhs = BigInteger::pow2(bitness - 1);
+    BigInteger rhs = BigInteger::pow2(bitness) - 1;
     return GetRandomPrimeNumbers(lhs, rhs, k);
 }
 
@@ -174,8 +170,8 @@ std::vector<BigInteger> Crypto::GetFirstPrimeNumbersWithSomeBitness(int bitness,
     if (bitness == 1) {
         return {};
     }
-    BigInteger lhs = BigInteger::pow(2, bitness - 1);
-    BigInteger rhs = BigInteger::pow(2, bitness) - 1;
+    BigInteger lhs = BigInteger::pow2(bitness - 1);
+    BigInteger rhs = BigInteger::pow2(bitness) - 1;
     return GetFirstPrimeNumbers(lhs, rhs, k);
 }
 
@@ -187,30 +183,30 @@ bool Crypto::MillerRabinTest(const BigInteger& number) {
         return false;
     }
     
-    int degree = 0;
-    BigInteger d = (number - 1);
-    BigInteger q = d;
-    while (d % 2 == 0) {
-        ++degree;
-        d /= 2;
-    }
+    const BigInteger q = number - 1;
+    const int degree = static_cast<int>(q.count_trailing_zeros());
+    const BigInteger d = q >> degree;
+
+    MontgomeryContext context(number);
+    const BigInteger one = context.one();
+    const BigInteger minus_one = context.ToMontgomery(q);
 
     for (int i = 0; i < std::max(10, degree); ++i) {
         BigInteger alpha = GetRandomNumber(BigInteger(2), number - 2);
-        BigInteger x = BigInteger::pow(alpha, d, number);
-        if (x == 1 || x == q) {
+        BigInteger x = context.pow_montgomery(alpha, d);
+        if (x == one || x == minus_one) {
             continue;
         }
         for (int j = 1; j < degree; ++j) {
-            x = (x * x) % number;
-            if (x == 1) {
+            x = context.sqr(x);
+            if (x == one) {
                 return false;
-            } else if (x == q) {
+            } else if (x == minus_one) {
                 break;
             }
         }
 
-        if (x != q) {
+        if (x != minus_one) {
             return false;
         }
     }
@@ -224,7 +220,7 @@ bool Crypto::LucasSelfridgeTest(const BigInteger& number) {
     if (number < 2 || number % 2 == 0) {
         return false;
     }
-    if (auto sq = BigInteger::sqrt(number); sq * sq == number) {
+    if (BigInteger::is_perfect_square(number)) {
         return false;
     }
     BigInteger d_sign;
@@ -242,36 +238,40 @@ bool Crypto::LucasSelfridgeTest(const BigInteger& number) {
     }
     BigInteger p = 1, q = (p - d_sign) / 4;
     BigInteger d = number + 1;
-    int step = 0;
-    while (d.IsEven()) {
-        ++step;
-        d /= 2;
-    }
-    BigInteger u = 1, v = p, u2m = 1, v2m = p, qm = q, qm2 = q*2, qkd = q;
-    std::string d_in_bit = d.GetBase2();
-    for (int i = (int)d_in_bit.size() - 2; i >= 0; --i) {
-        u2m = (u2m * v2m) % number;
-        v2m = (v2m * v2m) % number;
+    const int step = static_cast<int>(d.count_trailing_zeros());
+    d >>= step;
+
+    /// All the sequence members are kept in Montgomery form modulo number
+    MontgomeryContext context(number);
+    const BigInteger d_mont = context.ToMontgomery(d_sign);
+    const BigInteger p_mont = context.ToMontgomery(p);
+    const BigInteger q_mont = context.ToMontgomery(q);
+
+    BigInteger u = context.one(), v = p_mont, u2m = context.one(), v2m = p_mont,
+               qm = q_mont, qm2 = q_mont * 2, qkd = q_mont;
+    for (int i = (int)d.bit_length() - 2; i >= 0; --i) {
+        u2m = context.mul(u2m, v2m);
+        v2m = context.sqr(v2m);
         while (v2m < qm2) {
             v2m += number;
         }
         v2m -= qm2;
-        qm = (qm * qm) % number;
+        qm = context.sqr(qm);
         qm2 = qm * 2;
-        if (d_in_bit[i] == '1') {
-            BigInteger t1 = (u2m * v) % number,  t2 = (v2m * u) % number,
-                       t3 = (v2m * v) % number,  t4 = (((u2m * u) % number) * d_sign) % number;
+        if (d.test_bit(i)) {
+            BigInteger t1 = context.mul(u2m, v),  t2 = context.mul(v2m, u),
+                       t3 = context.mul(v2m, v),  t4 = context.mul(context.mul(u2m, u), d_mont);
             u = t1 + t2;
             if (u.IsOdd()) {
                 u += number;
             }
-            u = (u / 2) % number;
+            u = (u >> 1) % number;
             v = t3 + t4;
             if (v.IsOdd()) {
                 v += number;
             }
-            v = (v / 2) % number;
-            qkd = (qkd * qm) % number;
+            v = (v >> 1) % number;
+            qkd = context.mul(qkd, qm);
         }
     }
     if (u==0 || v==0) {
@@ -287,13 +287,13 @@ bool Crypto::LucasSelfridgeTest(const BigInteger& number) {
                 x -= number;
             }
         };
-        v = (v * v) % number - qkd2;
+        v = context.sqr(v) - qkd2;
         Normalize(v);
         if (v == 0) {
             return true;
         }
         if (r < step - 1) {
-            qkd = (qkd * 1ll * qkd) % number;
+            qkd = context.sqr(qkd);
             qkd2 = qkd * 2;
         }
     }
@@ -339,19 +339,28 @@ void Crypto::PollardRhoAlgorithm(const BigInteger& number, std::vector<BigIntege
         return;
     }
 
+    const BarrettReducer reducer(number);
+    auto Step = [&reducer, &number](const BigInteger& x, const BigInteger& c) {
+        BigInteger result = reducer.sqrmod(x) + c;
+        if (result >= number) {
+            result -= number;
+        }
+        return result;
+    };
+
     while (cur_limit != 0) {
         --cur_limit;
         
-        BigInteger x = GetRandomNumber(number);
+        BigInteger x = reducer.reduce(GetRandomNumber(number));
         BigInteger y = x;
-        BigInteger c = GetRandomNumber(number);
+        BigInteger c = reducer.reduce(GetRandomNumber(number));
         BigInteger g = 1;
         BigInteger diff = 0;
         
         while (g == 1) {
-            x = ((x * x) % number + c) % number;
-            y = ((y * y) % number + c) % number;
-            y = ((y * y) % number + c) % number;
+            x = Step(x, c);
+            y = Step(y, c);
+            y = Step(y, c);
             diff = BigInteger::abs(x - y);
             g = BigInteger::gcd(diff, number);
         }
@@ -444,11 +453,8 @@ int Crypto::JacobySymbol(BigInteger a, BigInteger p) {
     }
     
     do {
-        int t = 0;
-        while (a % 2 == 0) {
-            ++t;
-            a /= 2;
-        }
+        const size_t t = a.count_trailing_zeros();
+        a >>= t;
         if (t % 2 == 1) {
             if (p % 8 == 3 || p % 8 == 5) {
                 result = -result;
@@ -478,18 +484,19 @@ BigInteger Crypto::CipollaAlgorithm(BigInteger n, const BigInteger& p) {
         return -1;
     }
     
+    const BarrettReducer reducer(p);
     fp2 result;
     
     while (true) {
         BigInteger w2, a;
         do {
             a = GetRandomNumber(2, p);
-            w2 = a * a - n;
+            w2 = reducer.reduce(a * a - n);
         } while (LegendreSymbol(w2, p) != -1);
 
         result.first = a;
         result.second = 1;
-        result = fp2pow(result, (p + 1) / 2, p, w2);
+        result = fp2pow(result, (p + 1) / 2, reducer, w2);
         
         if (result.second != 0) {
             continue;
@@ -498,7 +505,7 @@ BigInteger Crypto::CipollaAlgorithm(BigInteger n, const BigInteger& p) {
         BigInteger x = result.first;
         BigInteger y = p - x;
                 
-        if ((x * x) % p == n && (y * y) % p == n) {
+        if (reducer.sqrmod(x) == n && reducer.sqrmod(y) == n) {
             break;
         }
     }
@@ -510,7 +517,8 @@ BigInteger Crypto::CipollaAlgorithm(BigInteger n, const BigInteger& p) {
 
 BigInteger Crypto::GiantStepBabyStep(const BigInteger& a, const BigInteger& b,
                                      const BigInteger& p) {
-    const BigInteger m = BigInteger::sqrt(p) + 1;
+    const BigInteger m = BigInteger::isqrt(p) + 1;
+    const BarrettReducer reducer(p);
     auto table = std::map<BigInteger, BigInteger>{};
     
     BigInteger an = BigInteger::pow(a, m, p);
@@ -519,7 +527,7 @@ BigInteger Crypto::GiantStepBabyStep(const BigInteger& a, const BigInteger& b,
         if (!table.count(cur)) {
             table[cur] = i;
         }
-        cur = (cur * an) % p;
+        cur = reducer.mulmod(cur, an);
     }
     
     for (BigInteger i = 0, cur = b; i <= m; i += 1) {
@@ -529,7 +537,7 @@ BigInteger Crypto::GiantStepBabyStep(const BigInteger& a, const BigInteger& b,
                 return ans;
             }
         }
-        cur = (cur * a) % p;
+        cur = reducer.mulmod(cur, a);
     }
     
     return -1;
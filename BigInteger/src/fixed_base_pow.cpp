@@ -0,0 +1,110 @@
+#include "fixed_base_pow.h"
+
+#include <cassert>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace {
+    /// Tables of different generators are rare, the cache is just dropped when it gets full
+    constexpr size_t kMaxCachedTables = 16;
+}  // namespace
+
+FixedBasePow::FixedBasePow(const BigInteger& base, const BigInteger& modulus,
+                           size_t max_power_bits, size_t teeth)
+        : modulus_(modulus), teeth_(teeth) {
+    assert(modulus_ > 0);
+    assert(teeth_ >= 1 && teeth_ <= 16);
+    if (max_power_bits == 0) {
+        max_power_bits = modulus_.bit_length();
+    }
+    rows_length_ = (max_power_bits + teeth_ - 1) / teeth_;
+
+    base_ = BigInteger::mod(base, modulus_);
+    BigInteger one = BigInteger::mod(BigInteger(1), modulus_);
+    BigInteger row = base_;
+    if (modulus_.IsOdd() && modulus_ > 1) {
+        montgomery_ = std::make_unique<MontgomeryContext>(modulus_);
+        one = montgomery_->one();
+        row = montgomery_->ToMontgomery(base_);
+    } else {
+        barrett_ = std::make_unique<BarrettReducer>(modulus_);
+    }
+
+    /// table_[2^j + v] = table_[v] * g ^ (2 ^ (j * d)) for v < 2^j
+    table_.assign(size_t(1) << teeth_, one);
+    for (size_t j = 0; j < teeth_; ++j) {
+        if (j > 0) {
+            for (size_t i = 0; i < rows_length_; ++i) {
+                row = sqr(row);
+            }
+        }
+        const size_t high = size_t(1) << j;
+        table_[high] = row;
+        for (size_t v = 1; v < high; ++v) {
+            table_[high + v] = mul(table_[v], row);
+        }
+    }
+}
+
+std::shared_ptr<const FixedBasePow> FixedBasePow::Get(const BigInteger& base, const BigInteger& modulus) {
+    static std::mutex mutex;
+    static std::map<std::pair<BigInteger, BigInteger>, std::shared_ptr<const FixedBasePow>> cache;
+
+    std::pair<BigInteger, BigInteger> key(base, modulus);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(key);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    /// Built outside of the lock, two threads racing for one key just build it twice
+    auto table = std::make_shared<const FixedBasePow>(base, modulus);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cache.size() >= kMaxCachedTables) {
+        cache.clear();
+    }
+    return cache.emplace(std::move(key), std::move(table)).first->second;
+}
+
+const BigInteger& FixedBasePow::GetBase() const {
+    return base_;
+}
+
+const BigInteger& FixedBasePow::GetModulus() const {
+    return modulus_;
+}
+
+BigInteger FixedBasePow::pow(const BigInteger& power) const {
+    assert(power.IsPositive());
+    if (power.bit_length() > teeth_ * rows_length_) {
+        return BigInteger::pow(base_, power, modulus_);
+    }
+
+    BigInteger result = table_[0];
+    bool is_one = true;
+    for (size_t i = rows_length_; i > 0; --i) {
+        if (!is_one) {
+            result = sqr(result);
+        }
+        size_t v = 0;
+        for (size_t j = teeth_; j > 0; --j) {
+            v = (v << 1) | (power.test_bit((j - 1) * rows_length_ + i - 1) ? 1 : 0);
+        }
+        if (v != 0) {
+            result = is_one ? table_[v] : mul(result, table_[v]);
+            is_one = false;
+        }
+    }
+    return montgomery_ ? montgomery_->FromMontgomery(result) : result;
+}
+
+BigInteger FixedBasePow::mul(const BigInteger& lhs, const BigInteger& rhs) const {
+    return montgomery_ ? montgomery_->mul(lhs, rhs) : barrett_->mulmod(lhs, rhs);
+}
+
+BigInteger FixedBasePow::sqr(const BigInteger& x) const {
+    return montgomery_ ? montgomery_->sqr(x) : barrett_->sqrmod(x);
+}
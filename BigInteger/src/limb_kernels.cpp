@@ -0,0 +1,184 @@
+#include "limb_kernels.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LIMB_KERNELS_X86_64
+#include <immintrin.h>
+#endif
+
+namespace {
+    using Limb = uint64_t;
+    using DoubleLimb = unsigned __int128;
+
+    Limb AddPortable(Limb* result, const Limb* a, const Limb* b, size_t n) {
+        Limb carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const DoubleLimb cur = (DoubleLimb)a[i] + b[i] + carry;
+            result[i] = static_cast<Limb>(cur);
+            carry = static_cast<Limb>(cur >> 64);
+        }
+        return carry;
+    }
+
+    Limb SubPortable(Limb* result, const Limb* a, const Limb* b, size_t n) {
+        Limb borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const Limb sub = b[i] + borrow;
+            const Limb next = (sub < borrow || a[i] < sub) ? 1 : 0;
+            result[i] = a[i] - sub;
+            borrow = next;
+        }
+        return borrow;
+    }
+
+    Limb AddMulPortable(Limb* result, const Limb* a, size_t n, Limb b) {
+        Limb carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const DoubleLimb cur = (DoubleLimb)a[i] * b + result[i] + carry;
+            result[i] = static_cast<Limb>(cur);
+            carry = static_cast<Limb>(cur >> 64);
+        }
+        return carry;
+    }
+
+    Limb SubMulPortable(Limb* result, const Limb* a, size_t n, Limb b) {
+        Limb borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const DoubleLimb product = (DoubleLimb)a[i] * b + borrow;
+            const Limb low = static_cast<Limb>(product);
+            borrow = static_cast<Limb>(product >> 64) + (result[i] < low ? 1 : 0);
+            result[i] -= low;
+        }
+        return borrow;
+    }
+
+#ifdef LIMB_KERNELS_X86_64
+    using Word = unsigned long long;
+
+    /// One carry chain through ADC, unrolled by four, so the flag isn't spilled between limbs
+    Limb AddX86(Limb* result, const Limb* a, const Limb* b, size_t n) {
+        unsigned char carry = 0;
+        Word* out = reinterpret_cast<Word*>(result);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            carry = _addcarry_u64(carry, a[i], b[i], out + i);
+            carry = _addcarry_u64(carry, a[i + 1], b[i + 1], out + i + 1);
+            carry = _addcarry_u64(carry, a[i + 2], b[i + 2], out + i + 2);
+            carry = _addcarry_u64(carry, a[i + 3], b[i + 3], out + i + 3);
+        }
+        for (; i < n; ++i) {
+            carry = _addcarry_u64(carry, a[i], b[i], out + i);
+        }
+        return carry;
+    }
+
+    Limb SubX86(Limb* result, const Limb* a, const Limb* b, size_t n) {
+        unsigned char borrow = 0;
+        Word* out = reinterpret_cast<Word*>(result);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            borrow = _subborrow_u64(borrow, a[i], b[i], out + i);
+            borrow = _subborrow_u64(borrow, a[i + 1], b[i + 1], out + i + 1);
+            borrow = _subborrow_u64(borrow, a[i + 2], b[i + 2], out + i + 2);
+            borrow = _subborrow_u64(borrow, a[i + 3], b[i + 3], out + i + 3);
+        }
+        for (; i < n; ++i) {
+            borrow = _subborrow_u64(borrow, a[i], b[i], out + i);
+        }
+        return borrow;
+    }
+
+    /// MULX doesn't touch the flags, so the high halves of the products are added
+    /// by the OF chain of ADOX and the limbs of the result by the CF chain of ADCX.
+    /// The loop counter runs from -n to 0 through LEA and JRCXZ, which keep the flags.
+    __attribute__((target("bmi2,adx")))
+    Limb AddMulAdx(Limb* result, const Limb* a, size_t n, Limb b) {
+        if (n == 0) {
+            return 0;
+        }
+        Word high = 0;
+        Word low;
+        Word next_high;
+        long long index = -static_cast<long long>(n);
+        asm volatile(
+            "xor %[low], %[low]\n\t"
+            "1:\n\t"
+            "mulx (%[a], %[i], 8), %[low], %[next]\n\t"
+            "adox %[high], %[low]\n\t"
+            "adcx (%[r], %[i], 8), %[low]\n\t"
+            "mov %[low], (%[r], %[i], 8)\n\t"
+            "mov %[next], %[high]\n\t"
+            "lea 1(%[i]), %[i]\n\t"
+            "jrcxz 2f\n\t"
+            "jmp 1b\n\t"
+            "2:\n\t"
+            "mov $0, %[low]\n\t"
+            "adox %[low], %[high]\n\t"
+            "adcx %[low], %[high]\n\t"
+            : [high] "+&r"(high), [low] "=&r"(low), [next] "=&r"(next_high), [i] "+c"(index)
+            : [a] "r"(a + n), [r] "r"(result + n), "d"(b)
+            : "cc", "memory");
+        return high;
+    }
+
+    /// The same chains, result - s is computed as result + ~s + 1,
+    /// so the CF chain starts with one and the borrow is the inverted carry
+    __attribute__((target("bmi2,adx")))
+    Limb SubMulAdx(Limb* result, const Limb* a, size_t n, Limb b) {
+        if (n == 0) {
+            return 0;
+        }
+        Word high = 0;
+        Word low;
+        Word next_high;
+        long long index = -static_cast<long long>(n);
+        asm volatile(
+            "xor %[low], %[low]\n\t"
+            "stc\n\t"
+            "1:\n\t"
+            "mulx (%[a], %[i], 8), %[low], %[next]\n\t"
+            "adox %[high], %[low]\n\t"
+            "not %[low]\n\t"
+            "adcx (%[r], %[i], 8), %[low]\n\t"
+            "mov %[low], (%[r], %[i], 8)\n\t"
+            "mov %[next], %[high]\n\t"
+            "lea 1(%[i]), %[i]\n\t"
+            "jrcxz 2f\n\t"
+            "jmp 1b\n\t"
+            "2:\n\t"
+            "mov $0, %[low]\n\t"
+            "adox %[low], %[high]\n\t"
+            "cmc\n\t"
+            "adcx %[low], %[high]\n\t"
+            : [high] "+&r"(high), [low] "=&r"(low), [next] "=&r"(next_high), [i] "+c"(index)
+            : [a] "r"(a + n), [r] "r"(result + n), "d"(b)
+            : "cc", "memory");
+        return high;
+    }
+#endif
+
+    LimbKernels::Table ChooseNative() {
+        LimbKernels::Table table = LimbKernels::Portable();
+#ifdef LIMB_KERNELS_X86_64
+        table.name = "x86-64";
+        table.add = AddX86;
+        table.sub = SubX86;
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx")) {
+            table.name = "x86-64 bmi2 adx";
+            table.addmul = AddMulAdx;
+            table.submul = SubMulAdx;
+        }
+#endif
+        return table;
+    }
+}  // namespace
+
+const LimbKernels::Table& LimbKernels::Portable() {
+    static const Table table{"portable", AddPortable, SubPortable, AddMulPortable, SubMulPortable};
+    return table;
+}
+
+const LimbKernels::Table& LimbKernels::Native() {
+    static const Table table = ChooseNative();
+    return table;
+}
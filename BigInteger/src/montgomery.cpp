@@ -0,0 +1,200 @@
+#include "montgomery.h"
+#include "limb_kernels.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+    using Limb = MontgomeryContext::Limb;
+    using Limbs = MontgomeryContext::Limbs;
+    using DoubleLimb = unsigned __int128;
+
+    /// Inverse of an odd number modulo 2^64 by Newton iteration,
+    /// every step doubles the number of correct low bits
+    Limb InverseModWord(Limb x) {
+        Limb result = x;  // correct modulo 2^3
+        for (int i = 0; i < 5; ++i) {
+            result *= 2 - x * result;
+        }
+        return result;
+    }
+}  // namespace
+
+MontgomeryContext::MontgomeryContext(const BigInteger& modulus) : modulus_(modulus) {
+    assert(modulus_.IsPositive() && modulus_.IsOdd() && modulus_ > 1);
+    n_ = modulus_.num_;
+    size_ = n_.size();
+    n_prime_ = 0 - InverseModWord(n_[0]);
+
+    Limbs r(size_ + 1, 0);
+    r.back() = 1;
+    r_ = BigInteger(std::move(r)) % modulus_;
+    r2_ = (r_ * r_) % modulus_;
+}
+
+const BigInteger& MontgomeryContext::GetModulus() const {
+    return modulus_;
+}
+
+BigInteger MontgomeryContext::ToMontgomery(const BigInteger& x) const {
+    return mul(BigInteger::mod(x, modulus_), r2_);
+}
+
+BigInteger MontgomeryContext::FromMontgomery(const BigInteger& x) const {
+    return mul(x, 1);
+}
+
+const BigInteger& MontgomeryContext::one() const {
+    return r_;
+}
+
+BigInteger MontgomeryContext::mul(const BigInteger& lhs, const BigInteger& rhs) const {
+    Limbs a = expand(lhs);
+    Limbs b = expand(rhs);
+    Limbs result(size_);
+    Limbs scratch(size_ + 2);
+    multiply(a.data(), b.data(), result.data(), scratch.data());
+    return build(std::move(result));
+}
+
+BigInteger MontgomeryContext::sqr(const BigInteger& x) const {
+    Limbs a = expand(x);
+    Limbs result(size_);
+    Limbs scratch(2 * size_ + 1);
+    square(a.data(), result.data(), scratch.data());
+    return build(std::move(result));
+}
+
+BigInteger MontgomeryContext::pow(const BigInteger& number, const BigInteger& power) const {
+    Limbs scratch(2 * size_ + 1);
+    return leave(powLimbs(number, power, scratch), scratch.data());
+}
+
+BigInteger MontgomeryContext::pow_montgomery(const BigInteger& number, const BigInteger& power) const {
+    Limbs scratch(2 * size_ + 1);
+    return build(powLimbs(number, power, scratch));
+}
+
+MontgomeryContext::Limbs MontgomeryContext::powLimbs(const BigInteger& number, const BigInteger& power,
+                                                     Limbs& scratch) const {
+    assert(power.IsPositive());
+    return BigInteger::slidingWindowPow(
+            expand(ToMontgomery(number)), expand(r_), power,
+            [this, &scratch](const Limbs& lhs, const Limbs& rhs,
+                             Limbs& product) {
+                multiply(lhs.data(), rhs.data(), product.data(), scratch.data());
+            },
+            [this, &scratch](const Limbs& x, Limbs& product) {
+                square(x.data(), product.data(), scratch.data());
+            });
+}
+
+BigInteger MontgomeryContext::multi_pow(const std::vector<BigInteger>& numbers,
+                                        const std::vector<BigInteger>& powers) const {
+    assert(numbers.size() == powers.size());
+
+    std::vector<Limbs> residues;
+    residues.reserve(numbers.size());
+    for (const auto& number : numbers) {
+        residues.push_back(expand(ToMontgomery(number)));
+    }
+    Limbs scratch(2 * size_ + 1);
+    Limbs result = BigInteger::slidingWindowMultiPow(
+            residues, expand(r_), powers,
+            [this, &scratch](const Limbs& lhs, const Limbs& rhs,
+                             Limbs& product) {
+                multiply(lhs.data(), rhs.data(), product.data(), scratch.data());
+            },
+            [this, &scratch](const Limbs& x, Limbs& product) {
+                square(x.data(), product.data(), scratch.data());
+            });
+    return leave(result, scratch.data());
+}
+
+BigInteger MontgomeryContext::leave(const Limbs& x, Limb* scratch) const {
+    Limbs unit(size_, 0);
+    unit[0] = 1;
+    Limbs result(size_);
+    multiply(x.data(), unit.data(), result.data(), scratch);
+    return build(std::move(result));
+}
+
+void MontgomeryContext::multiply(const Limb* lhs, const Limb* rhs, Limb* result,
+                                 Limb* scratch) const {
+    /// Coarsely Integrated Operand Scanning (CIOS):
+    /// t = (t + lhs * rhs[i] + m * N) / 2^64 for every limb of rhs
+    Limb* t = scratch;
+    std::fill(t, t + size_ + 2, 0);
+    for (size_t i = 0; i < size_; ++i) {
+        Limb carry = LimbKernels::AddMul(t, lhs, size_, rhs[i]);
+        DoubleLimb cur = (DoubleLimb)t[size_] + carry;
+        t[size_] = static_cast<Limb>(cur);
+        t[size_ + 1] = static_cast<Limb>(cur >> 64);
+
+        const Limb m = t[0] * n_prime_;
+        cur = (DoubleLimb)m * n_[0] + t[0];
+        carry = static_cast<Limb>(cur >> 64);
+        for (size_t j = 1; j < size_; ++j) {
+            cur = (DoubleLimb)m * n_[j] + t[j] + carry;
+            t[j - 1] = static_cast<Limb>(cur);
+            carry = static_cast<Limb>(cur >> 64);
+        }
+        cur = (DoubleLimb)t[size_] + carry;
+        t[size_ - 1] = static_cast<Limb>(cur);
+        t[size_] = t[size_ + 1] + static_cast<Limb>(cur >> 64);
+    }
+    normalize(t, result);
+}
+
+void MontgomeryContext::square(const Limb* x, Limb* result, Limb* scratch) const {
+    /// Separated operand scanning: the symmetric square takes about half of
+    /// the multiplications of a product, then t * R^(-1) is reduced limb by limb
+    Limb* t = scratch;
+    BigInteger::getUnsignedSquare(x, size_, t);
+    t[2 * size_] = 0;
+    for (size_t i = 0; i < size_; ++i) {
+        const Limb m = t[i] * n_prime_;
+        Limb carry = LimbKernels::AddMul(t + i, n_.data(), size_, m);
+        for (size_t pos = i + size_; carry != 0; ++pos) {
+            DoubleLimb cur = (DoubleLimb)t[pos] + carry;
+            t[pos] = static_cast<Limb>(cur);
+            carry = static_cast<Limb>(cur >> 64);
+        }
+    }
+    normalize(t + size_, result);
+}
+
+void MontgomeryContext::normalize(const Limb* t, Limb* result) const {
+    /// t < 2N, so at most one subtraction is needed
+    bool greater_or_equal = (t[size_] != 0);
+    if (!greater_or_equal) {
+        greater_or_equal = true;
+        for (size_t j = size_; j > 0; --j) {
+            if (t[j - 1] != n_[j - 1]) {
+                greater_or_equal = (t[j - 1] > n_[j - 1]);
+                break;
+            }
+        }
+    }
+    if (greater_or_equal) {
+        Limb borrow = 0;
+        for (size_t j = 0; j < size_; ++j) {
+            Limb sub = n_[j] + borrow;
+            borrow = (sub < borrow || t[j] < sub) ? 1 : 0;
+            result[j] = t[j] - sub;
+        }
+    } else {
+        std::copy(t, t + size_, result);
+    }
+}
+
+Limbs MontgomeryContext::expand(const BigInteger& x) const {
+    assert(x.IsPositive() && x < modulus_);
+    Limbs result = x.num_;
+    result.resize(size_, 0);
+    return result;
+}
+
+BigInteger MontgomeryContext::build(Limbs limbs) {
+    return BigInteger(std::move(limbs));
+}
@@ -0,0 +1,205 @@
+#include "ntt.h"
+
+#include "scratch_arena.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+    using Limb = uint64_t;
+    using DoubleLimb = unsigned __int128;
+
+    /// Arithmetic modulo a prime p < 2^62 with values in Montgomery form x * 2^64 mod p
+    class PrimeField {
+      public:
+        PrimeField(Limb p, Limb generator) : p_(p) {
+            Limb inverse = p;
+            for (int i = 0; i < 5; ++i) {
+                inverse *= 2 - p * inverse;
+            }
+            p_neg_inv_ = 0 - inverse;
+            const Limb r = static_cast<Limb>((DoubleLimb(1) << 64) % p);
+            r2_ = static_cast<Limb>((DoubleLimb)r * r % p);
+            generator_ = to(generator);
+        }
+
+        Limb modulus() const { return p_; }
+
+        Limb reduce(DoubleLimb t) const {
+            const Limb m = static_cast<Limb>(t) * p_neg_inv_;
+            const Limb result = static_cast<Limb>((t + (DoubleLimb)m * p_) >> 64);
+            return (result >= p_ ? result - p_ : result);
+        }
+
+        Limb mul(Limb lhs, Limb rhs) const { return reduce((DoubleLimb)lhs * rhs); }
+        Limb add(Limb lhs, Limb rhs) const {
+            const Limb sum = lhs + rhs;
+            return (sum >= p_ ? sum - p_ : sum);
+        }
+        Limb sub(Limb lhs, Limb rhs) const { return (lhs >= rhs ? lhs - rhs : lhs + p_ - rhs); }
+
+        Limb to(Limb x) const { return mul(x % p_, r2_); }
+        Limb from(Limb x) const { return reduce(x); }
+
+        Limb pow(Limb number, Limb power) const {
+            Limb result = to(1);
+            for (; power > 0; power >>= 1) {
+                if (power & 1) {
+                    result = mul(result, number);
+                }
+                number = mul(number, number);
+            }
+            return result;
+        }
+
+        Limb inverse(Limb x) const { return pow(x, p_ - 2); }
+
+        /// Primitive root of unity of the given order, which has to divide p - 1
+        Limb root(size_t order, bool inverse_root) const {
+            const Limb w = pow(generator_, (p_ - 1) / order);
+            return (inverse_root ? inverse(w) : w);
+        }
+
+      private:
+        Limb p_;
+        Limb p_neg_inv_;
+        Limb r2_;
+        Limb generator_;
+    };
+
+    /// p = c * 2^k + 1 with primitive root g, all of them are less than 2^62
+    const PrimeField* GetFields() {
+        static const PrimeField fields[3] = {
+            PrimeField(4179340454199820289ull, 3),  // 29 * 2^57 + 1
+            PrimeField(2485986994308513793ull, 5),  // 69 * 2^55 + 1
+            PrimeField(1945555039024054273ull, 5),  // 27 * 2^56 + 1
+        };
+        return fields;
+    }
+    constexpr size_t kMaxTransformSize = size_t(1) << 55;
+
+    /// In-place cyclic transform of n values in Montgomery form, n is a power of two
+    /// roots has to hold at least n / 2 values
+    void Transform(Limb* a, size_t n, const PrimeField& field, bool inverse, Limb* roots) {
+        for (size_t i = 1, j = 0; i < n; ++i) {
+            size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                std::swap(a[i], a[j]);
+            }
+        }
+
+        for (size_t len = 2; len <= n; len <<= 1) {
+            const size_t half = len / 2;
+            const Limb w = field.root(len, inverse);
+            roots[0] = field.to(1);
+            for (size_t j = 1; j < half; ++j) {
+                roots[j] = field.mul(roots[j - 1], w);
+            }
+            for (size_t i = 0; i < n; i += len) {
+                for (size_t j = 0; j < half; ++j) {
+                    const Limb u = a[i + j];
+                    const Limb v = field.mul(a[i + j + half], roots[j]);
+                    a[i + j] = field.add(u, v);
+                    a[i + j + half] = field.sub(u, v);
+                }
+            }
+        }
+
+        if (inverse) {
+            const Limb n_inverse = field.inverse(field.to(n % field.modulus()));
+            for (size_t i = 0; i < n; ++i) {
+                a[i] = field.mul(a[i], n_inverse);
+            }
+        }
+    }
+}  // namespace
+
+void NTT::Multiply(const uint64_t* a, size_t na, const uint64_t* b, size_t nb, uint64_t* result) {
+    const size_t total = na + nb;
+    size_t n = 1;
+    while (n < total) {
+        n <<= 1;
+    }
+    assert(n <= kMaxTransformSize);
+    const bool square = (a == b && na == nb);
+    const PrimeField* fields = GetFields();
+
+    ScratchArena::Scope scope;
+    Limb* residues[3];
+    Limb* other = (square ? nullptr : scope.arena().allocate(n));
+    Limb* roots = scope.arena().allocate(std::max<size_t>(n / 2, 1));
+    for (int k = 0; k < 3; ++k) {
+        const PrimeField& field = fields[k];
+        Limb* values = residues[k] = scope.arena().allocate(n);
+
+        for (size_t i = 0; i < n; ++i) {
+            values[i] = (i < na ? field.to(a[i]) : 0);
+        }
+        Transform(values, n, field, false, roots);
+        if (square) {
+            for (size_t i = 0; i < n; ++i) {
+                values[i] = field.mul(values[i], values[i]);
+            }
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                other[i] = (i < nb ? field.to(b[i]) : 0);
+            }
+            Transform(other, n, field, false, roots);
+            for (size_t i = 0; i < n; ++i) {
+                values[i] = field.mul(values[i], other[i]);
+            }
+        }
+        Transform(values, n, field, true, roots);
+        for (size_t i = 0; i < n; ++i) {
+            values[i] = field.from(values[i]);
+        }
+    }
+
+    /// Garner's algorithm: x = x1 + x2 * p1 + x3 * p1 * p2, every coefficient is
+    /// less than n * 2^128 < p1 * p2 * p3, so it is restored exactly
+    const PrimeField& f1 = fields[0];
+    const PrimeField& f2 = fields[1];
+    const PrimeField& f3 = fields[2];
+    const Limb p1 = f1.modulus();
+    const Limb p2 = f2.modulus();
+    /// Montgomery forms of the inverses, so f.mul(x, inverse) gives x * p^(-1) in the ordinary form
+    const Limb inv_p1_p2 = f2.inverse(f2.to(p1));
+    const Limb inv_p1_p3 = f3.inverse(f3.to(p1));
+    const Limb inv_p2_p3 = f3.inverse(f3.to(p2));
+    const DoubleLimb p12 = (DoubleLimb)p1 * p2;
+    const Limb p12_low = static_cast<Limb>(p12);
+    const Limb p12_high = static_cast<Limb>(p12 >> 64);
+
+    std::fill(result, result + total, 0);
+    for (size_t i = 0; i < total; ++i) {
+        const Limb x1 = residues[0][i];
+        const Limb x2 = f2.mul(f2.sub(residues[1][i], x1 % p2), inv_p1_p2);
+        const Limb x3 = f3.mul(f3.sub(f3.mul(f3.sub(residues[2][i], x1 % f3.modulus()), inv_p1_p3),
+                                      x2 % f3.modulus()),
+                               inv_p2_p3);
+
+        const DoubleLimb low = (DoubleLimb)x2 * p1 + x1;
+        DoubleLimb cur = (DoubleLimb)x3 * p12_low + static_cast<Limb>(low);
+        Limb value[3];
+        value[0] = static_cast<Limb>(cur);
+        cur = (DoubleLimb)x3 * p12_high + static_cast<Limb>(low >> 64) + static_cast<Limb>(cur >> 64);
+        value[1] = static_cast<Limb>(cur);
+        value[2] = static_cast<Limb>(cur >> 64);
+
+        Limb carry = 0;
+        size_t pos = i;
+        for (int j = 0; j < 3 && pos < total; ++j, ++pos) {
+            cur = (DoubleLimb)result[pos] + value[j] + carry;
+            result[pos] = static_cast<Limb>(cur);
+            carry = static_cast<Limb>(cur >> 64);
+        }
+        for (; carry != 0 && pos < total; ++pos) {
+            result[pos] += carry;
+            carry = (result[pos] == 0 ? 1 : 0);
+        }
+    }
+}
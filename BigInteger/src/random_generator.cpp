@@ -0,0 +1,172 @@
+#include "random_generator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <utility>
+
+namespace {
+    /// "expand 32-byte k"
+    constexpr std::array<uint32_t, 4> kChaChaConstants{0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+    constexpr int kChaChaDoubleRounds = 10;
+
+    uint32_t RotateLeft(uint32_t x, int bits) {
+        return (x << bits) | (x >> (32 - bits));
+    }
+
+    void QuarterRound(std::array<uint32_t, 16>& x, int a, int b, int c, int d) {
+        x[a] += x[b]; x[d] = RotateLeft(x[d] ^ x[a], 16);
+        x[c] += x[d]; x[b] = RotateLeft(x[b] ^ x[c], 12);
+        x[a] += x[b]; x[d] = RotateLeft(x[d] ^ x[a], 8);
+        x[c] += x[d]; x[b] = RotateLeft(x[b] ^ x[c], 7);
+    }
+
+    uint64_t SplitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    std::array<uint32_t, 8> RandomDeviceKey() {
+        std::random_device device;
+        std::array<uint32_t, 8> key;
+        for (auto& word : key) {
+            word = device();
+        }
+        return key;
+    }
+
+    std::array<uint32_t, 8> ExpandSeed(uint64_t seed) {
+        std::array<uint32_t, 8> key;
+        for (size_t i = 0; i < key.size(); i += 2) {
+            const uint64_t word = SplitMix64(seed);
+            key[i] = static_cast<uint32_t>(word);
+            key[i + 1] = static_cast<uint32_t>(word >> 32);
+        }
+        return key;
+    }
+
+    /// Mask of the top limb of a number of the given bit length
+    RandomGenerator::Limb TopLimbMask(size_t bits) {
+        return (bits % 64 == 0 ? ~RandomGenerator::Limb(0) : (RandomGenerator::Limb(1) << (bits % 64)) - 1);
+    }
+}  // namespace
+
+RandomGenerator::RandomGenerator() : RandomGenerator(RandomDeviceKey()) {
+}
+
+RandomGenerator::RandomGenerator(uint64_t seed) : RandomGenerator(ExpandSeed(seed)) {
+}
+
+RandomGenerator::RandomGenerator(const std::array<uint32_t, 8>& key) {
+    /// Constants, key, 64-bit block counter and zero nonce
+    state_.fill(0);
+    std::copy(kChaChaConstants.begin(), kChaChaConstants.end(), state_.begin());
+    std::copy(key.begin(), key.end(), state_.begin() + 4);
+}
+
+RandomGenerator::Limb RandomGenerator::Next() {
+    if (buffered_ == 0) {
+        generateBlock(buffer_.data());
+        buffered_ = kBlockLimbs;
+    }
+    return buffer_[kBlockLimbs - buffered_--];
+}
+
+void RandomGenerator::Fill(Limb* out, size_t count) {
+    for (; count > 0 && buffered_ > 0; --count) {
+        *out++ = Next();
+    }
+    /// Whole blocks go straight to the output
+    for (; count >= kBlockLimbs; count -= kBlockLimbs, out += kBlockLimbs) {
+        generateBlock(out);
+    }
+    for (; count > 0; --count) {
+        *out++ = Next();
+    }
+}
+
+BigInteger RandomGenerator::GetNumber(const BigInteger& max_value) {
+    BigInteger result;
+    drawUpTo(max_value, result.num_);
+    result.validate();
+    return result;
+}
+
+BigInteger RandomGenerator::GetNumber(const BigInteger& min_value, const BigInteger& max_value) {
+    assert(min_value <= max_value);
+    return min_value + GetNumber(max_value - min_value);
+}
+
+BigInteger RandomGenerator::GetNumberWithBitness(size_t bitness) {
+    assert(bitness >= 1);
+    BigInteger::Limbs number((bitness + 63) / 64);
+    Fill(number.data(), number.size());
+    number.back() &= TopLimbMask(bitness);
+    number.back() |= Limb(1) << ((bitness - 1) % 64);
+    return BigInteger(std::move(number));
+}
+
+std::vector<BigInteger> RandomGenerator::GetNumbers(const BigInteger& min_value,
+                                                    const BigInteger& max_value, size_t count) {
+    assert(min_value <= max_value);
+    const BigInteger range = max_value - min_value;
+    std::vector<BigInteger> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        BigInteger offset;
+        drawUpTo(range, offset.num_);
+        offset.validate();
+        result.push_back(min_value + std::move(offset));
+    }
+    return result;
+}
+
+std::vector<BigInteger> RandomGenerator::GetNumbersWithBitness(size_t bitness, size_t count) {
+    std::vector<BigInteger> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(GetNumberWithBitness(bitness));
+    }
+    return result;
+}
+
+RandomGenerator& RandomGenerator::ForThread() {
+    thread_local RandomGenerator generator;
+    return generator;
+}
+
+void RandomGenerator::generateBlock(Limb* out) {
+    std::array<uint32_t, 16> x = state_;
+    for (int round = 0; round < kChaChaDoubleRounds; ++round) {
+        QuarterRound(x, 0, 4, 8, 12);
+        QuarterRound(x, 1, 5, 9, 13);
+        QuarterRound(x, 2, 6, 10, 14);
+        QuarterRound(x, 3, 7, 11, 15);
+        QuarterRound(x, 0, 5, 10, 15);
+        QuarterRound(x, 1, 6, 11, 12);
+        QuarterRound(x, 2, 7, 8, 13);
+        QuarterRound(x, 3, 4, 9, 14);
+    }
+    for (size_t i = 0; i < kBlockLimbs; ++i) {
+        out[i] = static_cast<Limb>(x[2 * i] + state_[2 * i]) |
+                 (static_cast<Limb>(x[2 * i + 1] + state_[2 * i + 1]) << 32);
+    }
+    if (++state_[12] == 0) {
+        ++state_[13];
+    }
+}
+
+void RandomGenerator::drawUpTo(const BigInteger& bound, BigInteger::Limbs& number) {
+    const size_t bits = bound.bit_length();
+    if (bits == 0) {
+        number.assign(1, 0);
+        return;
+    }
+    number.resize(bound.num_.size());
+    do {
+        Fill(number.data(), number.size());
+        number.back() &= TopLimbMask(bits);
+    } while (BigInteger::compareUnsignedNumbers(number, bound.num_) == BigInteger::CompareSign::GREATER);
+}
@@ -28,30 +28,6 @@ BigInteger GetCoprime(const BigInteger& phi) {
     }
     return w;
 }
-
-BigInteger EuclideanExtended(const BigInteger& x, const BigInteger& y) {
-    if (BigInteger::gcd(x, y) != 1) {
-        assert(false);
-    }
-    std::vector<BigInteger> r;
-    r.push_back(y);
-    r.push_back(x);
-    while (r.back() != 1) {
-        BigInteger lhs = r[(int)r.size() - 2];
-        BigInteger rhs = r.back();
-        r.push_back(lhs % rhs);
-    }
-    std::vector<BigInteger> a;
-    a.emplace_back(0);
-    a.emplace_back(1);
-    for (int i = 2; i < r.size(); ++i) {
-        BigInteger q = r[i - 2] / r[i - 1];
-        BigInteger cur = (a[i - 2] - ((a[i - 1] * q) % y) + y) % y;
-        a.push_back(cur);
-    }
-
-    return a.back();
-}
 }  // namespace
 
 namespace RSA {
@@ -69,7 +45,12 @@ void Bob::Init(const BigInteger &p, const BigInteger &q) {
     phi_ = BigInteger::lcm(p_ - 1, q_ - 1);
 
     e_ = GetCoprime(phi_);
-    d_ = EuclideanExtended(e_, phi_);
+    d_ = BigInteger::inverse_mod(e_, phi_).value();
+
+    dp_ = d_ % (p_ - 1);
+    dq_ = d_ % (q_ - 1);
+    p_context_.emplace(p_);
+    q_context_.emplace(q_);
 }
 
 const BigInteger& Bob::GetModule() const {
@@ -90,8 +71,8 @@ Key Bob::GetPrivateKey() const {
 
 BigInteger Bob::Decode(const BigInteger &c) {
     EASY_FUNCTION();
-    BigInteger mp = BigInteger::pow(c, d_ % (p_ - 1), p_);
-    BigInteger mq = BigInteger::pow(c, d_ % (q_ - 1), q_);
+    BigInteger mp = p_context_->pow(c, dp_);
+    BigInteger mq = q_context_->pow(c, dq_);
 
     CRT_Solver crt;
     crt.add_equation(1, mp, p_);
@@ -129,9 +110,8 @@ std::vector<BigInteger> TextConvertor::ConvertFromText(const std::string &text,
 std::string TextConvertor::ConvertToText(BigInteger symbols) {
     std::string result;
     while (symbols > 0) {
-        int r = (symbols % kAlphabetSize).ToInt();
+        int r = static_cast<int>(BigInteger::divmod_small(symbols, kAlphabetSize, symbols));
         result += ConvertToChar(r);
-        symbols /= kAlphabetSize;
     }
     return result;
 }
@@ -158,7 +138,7 @@ BigInteger GetHash(const BigInteger& key, const BigInteger& mod, const std::stri
     BigInteger result = 0;
     BigInteger step = 1;
     for (int i = 0; i < message.size(); ++i) {
-        int c = static_cast<int>(message[i]) + 1;
+        int c = static_cast<int>(static_cast<unsigned char>(message[i])) + 1;
         BigInteger cur = (key * c) % mod;
         result += cur;
         result %= mod;
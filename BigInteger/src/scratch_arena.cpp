@@ -0,0 +1,65 @@
+#include "scratch_arena.h"
+#include "big_integer_stats.h"
+
+#include <algorithm>
+
+ScratchArena::Scope::Scope()
+        : arena_(ScratchArena::local()),
+          block_(arena_.block_),
+          offset_(arena_.offset_),
+          used_(arena_.used_) {
+    ++arena_.depth_;
+}
+
+ScratchArena::Scope::~Scope() {
+    arena_.block_ = block_;
+    arena_.offset_ = offset_;
+    arena_.used_ = used_;
+    if (--arena_.depth_ == 0 && arena_.blocks_.size() > 1) {
+        arena_.coalesce();
+    }
+}
+
+ScratchArena& ScratchArena::local() {
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+ScratchArena::Limb* ScratchArena::allocate(size_t count) {
+    ++stats_.allocations;
+    while (block_ < blocks_.size() && offset_ + count > blocks_[block_].size) {
+        ++block_;
+        offset_ = 0;
+    }
+    if (block_ == blocks_.size()) {
+        const size_t size = std::max({count, capacity(), kMinBlockSize});
+        blocks_.push_back({std::make_unique<Limb[]>(size), size});
+        ++stats_.heap_allocations;
+        BIGINTEGER_STATS_ALLOCATION(size * sizeof(Limb));
+        offset_ = 0;
+    }
+
+    Limb* result = blocks_[block_].data.get() + offset_;
+    offset_ += count;
+    used_ += count;
+    stats_.peak_usage = std::max(stats_.peak_usage, used_);
+    return result;
+}
+
+size_t ScratchArena::capacity() const {
+    size_t result = 0;
+    for (const auto& block : blocks_) {
+        result += block.size;
+    }
+    return result;
+}
+
+void ScratchArena::coalesce() {
+    const size_t size = capacity();
+    blocks_.clear();
+    blocks_.push_back({std::make_unique<Limb[]>(size), size});
+    ++stats_.heap_allocations;
+    BIGINTEGER_STATS_ALLOCATION(size * sizeof(Limb));
+    block_ = 0;
+    offset_ = 0;
+}
@@ -0,0 +1,133 @@
+#include "task_pool.h"
+
+#include <algorithm>
+
+namespace {
+    /// Pool and queue of the current worker thread, nothing for other threads
+    thread_local const TaskPool* current_pool = nullptr;
+    thread_local size_t current_queue = 0;
+
+    std::unique_ptr<TaskPool>& GlobalPool() {
+        static std::unique_ptr<TaskPool> pool = std::make_unique<TaskPool>(
+                std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        return pool;
+    }
+}  // namespace
+
+TaskPool::Group::Group(TaskPool& pool) : pool_(pool) {
+}
+
+TaskPool::Group::~Group() {
+    Wait();
+}
+
+void TaskPool::Group::Run(Task task) {
+    if (pool_.workers_ == 0) {
+        task();
+        return;
+    }
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.push({std::move(task), this});
+}
+
+void TaskPool::Group::Wait() {
+    while (pending_.load(std::memory_order_acquire) != 0) {
+        if (!pool_.tryRunOne()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+TaskPool::TaskPool(size_t workers) : workers_(workers) {
+    for (size_t i = 0; i <= workers_; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < workers_; ++i) {
+        threads_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t TaskPool::GetWorkers() const {
+    return workers_;
+}
+
+TaskPool& TaskPool::Global() {
+    return *GlobalPool();
+}
+
+void TaskPool::SetGlobalWorkers(size_t workers) {
+    GlobalPool() = std::make_unique<TaskPool>(workers);
+}
+
+void TaskPool::push(Item item) {
+    Queue& queue = *queues_[queueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.items.push_back(std::move(item));
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+    /// Taking the lock orders the notification after the check of a worker going to sleep
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    wake_.notify_one();
+}
+
+bool TaskPool::tryRunOne() {
+    const size_t self = queueIndex();
+    Item item;
+    bool found = false;
+    for (size_t i = 0; i < queues_.size() && !found; ++i) {
+        Queue& queue = *queues_[(self + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.items.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            item = std::move(queue.items.back());
+            queue.items.pop_back();
+        } else {
+            item = std::move(queue.items.front());
+            queue.items.pop_front();
+        }
+        found = true;
+    }
+    if (!found) {
+        return false;
+    }
+
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    item.task();
+    item.group->pending_.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void TaskPool::workerLoop(size_t index) {
+    current_pool = this;
+    current_queue = index;
+    while (true) {
+        if (tryRunOne()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this] {
+            return stop_ || queued_.load(std::memory_order_acquire) != 0;
+        });
+        if (stop_) {
+            return;
+        }
+    }
+}
+
+size_t TaskPool::queueIndex() const {
+    return (current_pool == this ? current_queue : workers_);
+}
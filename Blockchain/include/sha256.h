@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "big_integer.h"
+#include "fixed_uint.h"
 
 namespace SHA256 {
 
@@ -15,11 +16,14 @@ using Byte = unsigned char;
 
 constexpr int kBlockSize = 64;
 
+using Digest = FixedUInt<256>;
+
 /// Return 256-bit hash value
 std::vector<unsigned int> GetHash(const std::string& input_message);
 std::vector<unsigned int> GetHash(const BigInteger& number);
 
-/// Constructs an integer from its parts
+/// Constructs an integer from its parts, the first one is the most significant
+Digest      ConvertToDigest(const std::vector<unsigned int>& hash);
 BigInteger  ConvertToBigInteger(const std::vector<unsigned int>& hash);
 std::string ConvertToString(const BigInteger& hash);
 std::string ConvertToString(const std::vector<unsigned int>& hash);
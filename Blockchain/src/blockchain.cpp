@@ -196,15 +196,8 @@ BigInteger Block::FindTotalBlockHash() {
 }
 
 bool Block::ValidateHashWithNonce(const BigInteger& hash) const {
-    auto str = SHA256::ConvertToString(hash);
-
-    for (int j = 0; j < difficulty_; ++j) {
-        if (str[j] != '0') {
-            return false;
-        }
-    }
-
-    return true;
+    /// difficulty_ leading zeros of the 256-bit digest
+    return hash.bit_length() + difficulty_ <= 256;
 }
 
 BigInteger Block::RunMining() {
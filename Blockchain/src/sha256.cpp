@@ -147,35 +147,24 @@ std::vector<unsigned int> SHA256::GetHash(const BigInteger& number) {
     return GetHash(number.GetByte());
 }
 
-BigInteger SHA256::ConvertToBigInteger(const std::vector<unsigned int>& hash) {
-    BigInteger result = 0;
-
-    for (auto value : hash) {
-        BigInteger number(value);
-
-        result *= (1ll << 32ll);
-        result += number;
+SHA256::Digest SHA256::ConvertToDigest(const std::vector<unsigned int>& hash) {
+    assert(hash.size() * 32 <= 256);
+    Digest result;
+    for (size_t i = 0; i < hash.size(); ++i) {
+        const size_t pos = (hash.size() - 1 - i) * 32;
+        result[pos / 64] |= static_cast<Digest::Limb>(hash[i]) << (pos % 64);
     }
-
     return result;
 }
 
-std::string SHA256::ConvertToString(const BigInteger& hash) {
-    std::string result = hash.GetBase2();
-    std::reverse(result.begin(), result.end());
-
-    assert(result.size() <= 256);
-
-    while (result.size() < 256) {
-        result += "0";
-    }
+BigInteger SHA256::ConvertToBigInteger(const std::vector<unsigned int>& hash) {
+    return ConvertToDigest(hash).ToBigInteger();
+}
 
-    std::reverse(result.begin(), result.end());
-    return result;
+std::string SHA256::ConvertToString(const BigInteger& hash) {
+    return Digest::FromBigInteger(hash).GetBase2();
 }
 
 std::string SHA256::ConvertToString(const std::vector<unsigned int>& hash) {
-    BigInteger number = ConvertToBigInteger(hash);
-
-    return ConvertToString(number);
+    return ConvertToDigest(hash).GetBase2();
 }
\ No newline at end of file
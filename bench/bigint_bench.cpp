@@ -0,0 +1,276 @@
+//
+// Microbenchmarks of BigInteger arithmetic and radix conversions.
+//
+// Usage: bigint_bench [--sizes 64,256,...] [--filter substring] [--min-time seconds]
+//                     [--repetitions n] [--json output.json]
+//                     [--baseline baseline.json] [--tolerance 0.1]
+//
+// Every case is warmed up, calibrated to run at least min-time per repetition
+// and repeated, the median time is reported. With a baseline the results are
+// compared case by case, slower than baseline * (1 + tolerance) is a regression
+// and the exit code is 1.
+//
+
+#include "big_integer.h"
+#include "crypto_algorithms.h"
+#include "limb_kernels.h"
+
+#include "json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::vector<int> sizes{64, 256, 1024, 4096, 16384};
+        std::string filter;
+        double min_time = 0.1;
+        double warmup_time = 0.05;
+        int repetitions = 5;
+        std::string json_path;
+        std::string baseline_path;
+        double tolerance = 0.1;
+    };
+
+    /// Operands of one size, generated once for all cases
+    struct Operands {
+        BigInteger a, b;
+        /// Half as long as a, for division
+        BigInteger half;
+        /// Odd, for modular operations
+        BigInteger modulus;
+        std::string decimal, base2, base64, bytes;
+    };
+
+    struct Case {
+        std::string name;
+        std::function<BigInteger(const Operands&)> run;
+    };
+
+    struct Result {
+        std::string name;
+        int bits;
+        double ns_per_op;
+        double min_ns_per_op;
+        long long iterations;
+    };
+
+    /// Results are accumulated here, so the compiler can't drop the calls
+    volatile size_t sink = 0;
+
+    Operands MakeOperands(int bits) {
+        Operands operands;
+        operands.a = Crypto::GetRandomNumberWithBitness(bits);
+        operands.b = Crypto::GetRandomNumberWithBitness(bits);
+        operands.half = Crypto::GetRandomNumberWithBitness(std::max(bits / 2, 2));
+        operands.modulus = Crypto::GetRandomNumberWithBitness(bits);
+        if (operands.modulus.IsEven()) {
+            operands.modulus += 1;
+        }
+        operands.decimal = operands.a.ToString();
+        operands.base2 = operands.a.GetBase2();
+        operands.base64 = operands.a.GetBase64();
+        operands.bytes = operands.a.GetByte();
+        return operands;
+    }
+
+    std::vector<Case> MakeCases() {
+        return {
+            {"add", [](const Operands& x) { return x.a + x.b; }},
+            {"sub", [](const Operands& x) { return x.a - x.b; }},
+            {"mul", [](const Operands& x) { return x.a * x.b; }},
+            {"sqr", [](const Operands& x) { return BigInteger::sqr(x.a); }},
+            {"div", [](const Operands& x) { return x.a / x.half; }},
+            {"mod", [](const Operands& x) { return x.a % x.half; }},
+            {"pow_mod", [](const Operands& x) { return BigInteger::pow(x.a, x.b, x.modulus); }},
+            {"gcd", [](const Operands& x) { return BigInteger::gcd(x.a, x.b); }},
+            {"inverse_mod", [](const Operands& x) {
+                return BigInteger::inverse_mod(x.a, x.modulus).value_or(BigInteger(0));
+            }},
+            {"isqrt", [](const Operands& x) { return BigInteger::isqrt(x.a); }},
+            {"to_decimal", [](const Operands& x) { return BigInteger(x.a.ToString().size()); }},
+            {"from_decimal", [](const Operands& x) { return BigInteger(x.decimal); }},
+            {"to_base2", [](const Operands& x) { return BigInteger(x.a.GetBase2().size()); }},
+            {"from_base2", [](const Operands& x) { return BigInteger::GetFromBase2(x.base2); }},
+            {"to_hex", [](const Operands& x) { return BigInteger(x.a.GetHex().size()); }},
+            {"to_base64", [](const Operands& x) { return BigInteger(x.a.GetBase64().size()); }},
+            {"from_base64", [](const Operands& x) { return BigInteger::GetFromBase64(x.base64); }},
+            {"to_byte", [](const Operands& x) { return BigInteger(x.a.GetByte().size()); }},
+            {"from_byte", [](const Operands& x) { return BigInteger::GetFromByte(x.bytes); }},
+        };
+    }
+
+    /// Nanoseconds per call of iterations calls in a row
+    double Measure(const Case& bench_case, const Operands& operands, long long iterations) {
+        const auto start = Clock::now();
+        for (long long i = 0; i < iterations; ++i) {
+            sink = sink + bench_case.run(operands).data().size();
+        }
+        const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+    Result Run(const Case& bench_case, int bits, const Operands& operands, const Options& options) {
+        /// Warmup doubles the number of calls until it takes warmup_time,
+        /// the last estimate calibrates the iterations of one repetition
+        long long calls = 1;
+        double estimate = Measure(bench_case, operands, calls);
+        for (double spent = estimate * calls; spent < options.warmup_time * 1e9; spent += estimate * calls) {
+            calls *= 2;
+            estimate = Measure(bench_case, operands, calls);
+        }
+        const long long iterations = std::max(1LL, static_cast<long long>(options.min_time * 1e9 / estimate));
+
+        std::vector<double> samples;
+        for (int i = 0; i < options.repetitions; ++i) {
+            samples.push_back(Measure(bench_case, operands, iterations));
+        }
+        std::sort(samples.begin(), samples.end());
+        return {bench_case.name, bits, samples[samples.size() / 2], samples.front(), iterations};
+    }
+
+    std::string Key(const std::string& name, int bits) {
+        return name + "/" + std::to_string(bits);
+    }
+
+    /// Json::Load reads numbers without a fraction as int
+    double AsNumber(const Json::Node& node) {
+        return std::holds_alternative<int>(node) ? node.AsInt() : node.AsDouble();
+    }
+
+    std::map<std::string, double> LoadBaseline(const std::string& path) {
+        std::ifstream input(path);
+        if (!input) {
+            std::cerr << "Can't open baseline " << path << std::endl;
+            std::exit(2);
+        }
+        std::map<std::string, double> baseline;
+        const Json::Document document = Json::Load(input);
+        for (const auto& node : document.GetRoot().AsMap().at("results").AsArray()) {
+            const auto& result = node.AsMap();
+            baseline[Key(result.at("name").AsString(), result.at("bits").AsInt())] =
+                    AsNumber(result.at("ns_per_op"));
+        }
+        return baseline;
+    }
+
+    void SaveResults(const std::string& path, const std::vector<Result>& results) {
+        std::vector<Json::Node> nodes;
+        for (const auto& result : results) {
+            nodes.push_back(std::map<std::string, Json::Node>{
+                {"name", result.name},
+                {"bits", result.bits},
+                {"ns_per_op", result.ns_per_op},
+                {"min_ns_per_op", result.min_ns_per_op},
+                {"ops_per_sec", 1e9 / result.ns_per_op},
+                {"iterations", static_cast<int>(std::min<long long>(result.iterations, 1 << 30))},
+            });
+        }
+        std::ofstream output(path);
+        output << Json::Node(std::map<std::string, Json::Node>{
+            {"limb_kernels", std::string(LimbKernels::Native().name)},
+            {"results", std::move(nodes)},
+        }) << std::endl;
+    }
+
+    std::vector<int> ParseSizes(const std::string& list) {
+        std::vector<int> sizes;
+        std::stringstream stream(list);
+        for (std::string item; std::getline(stream, item, ',');) {
+            sizes.push_back(std::stoi(item));
+        }
+        return sizes;
+    }
+
+    Options ParseOptions(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value of " << arg << std::endl;
+                std::exit(2);
+            }
+            const std::string value = argv[++i];
+            if (arg == "--sizes") {
+                options.sizes = ParseSizes(value);
+            } else if (arg == "--filter") {
+                options.filter = value;
+            } else if (arg == "--min-time") {
+                options.min_time = std::stod(value);
+            } else if (arg == "--repetitions") {
+                options.repetitions = std::max(1, std::stoi(value));
+            } else if (arg == "--json") {
+                options.json_path = value;
+            } else if (arg == "--baseline") {
+                options.baseline_path = value;
+            } else if (arg == "--tolerance") {
+                options.tolerance = std::stod(value);
+            } else {
+                std::cerr << "Unknown option " << arg << std::endl;
+                std::exit(2);
+            }
+        }
+        return options;
+    }
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options options = ParseOptions(argc, argv);
+    std::map<std::string, double> baseline;
+    if (!options.baseline_path.empty()) {
+        baseline = LoadBaseline(options.baseline_path);
+    }
+
+    std::cout << "Limb kernels: " << LimbKernels::Native().name << std::endl;
+    std::cout << std::left << std::setw(14) << "case" << std::right << std::setw(7) << "bits"
+              << std::setw(16) << "ns/op" << std::setw(16) << "ops/sec" << std::setw(12) << "baseline"
+              << std::endl;
+
+    std::vector<Result> results;
+    int regressions = 0;
+    const std::vector<Case> cases = MakeCases();
+    for (int bits : options.sizes) {
+        const Operands operands = MakeOperands(bits);
+        for (const auto& bench_case : cases) {
+            if (bench_case.name.find(options.filter) == std::string::npos) {
+                continue;
+            }
+            const Result result = Run(bench_case, bits, operands, options);
+            results.push_back(result);
+
+            std::cout << std::left << std::setw(14) << result.name << std::right << std::setw(7) << bits
+                      << std::fixed << std::setprecision(1) << std::setw(16) << result.ns_per_op
+                      << std::setw(16) << 1e9 / result.ns_per_op;
+            auto it = baseline.find(Key(result.name, bits));
+            if (it != baseline.end()) {
+                const double ratio = result.ns_per_op / it->second;
+                std::cout << std::setprecision(2) << std::setw(11) << ratio << "x";
+                if (ratio > 1 + options.tolerance) {
+                    std::cout << "  REGRESSION";
+                    ++regressions;
+                }
+            }
+            std::cout << std::defaultfloat << std::endl;
+        }
+    }
+
+    if (!options.json_path.empty()) {
+        SaveResults(options.json_path, results);
+    }
+    if (!baseline.empty()) {
+        std::cout << regressions << " regression(s) over " << options.tolerance * 100 << "% tolerance"
+                  << std::endl;
+    }
+    return regressions == 0 ? 0 : 1;
+}
@@ -7,6 +7,7 @@
 #include "client.h"
 #include "big_integer.h"
 #include "crypto_algorithms.h"
+#include "fixed_base_pow.h"
 
 #include "AES.h"
 #include "SHA256.h"
@@ -53,7 +54,7 @@ void InitializePrivateKey(Client& client) {
     for (int i = 0; i < n; ++i) {
         if (i == my_pos) {
             /// I am first
-            BigInteger w = BigInteger::pow(diffie_hellman.g, diffie_hellman.my_public_key, diffie_hellman.p);
+            BigInteger w = FixedBasePow::Get(diffie_hellman.g, diffie_hellman.p)->pow(diffie_hellman.my_public_key);
             ChatMessage message;
             message.add_field("to", users[next]);
             message.add_field("value", w.ToString());
@@ -3,9 +3,11 @@
 //
 
 #include <cmath>
+#include <thread>
 
 #include "big_integer.h"
 #include "crypto_algorithms.h"
+#include "random_generator.h"
 
 #include "test_runner.h"
 
@@ -64,7 +66,116 @@ void PrimalityTests() {
 };
 
 
+void FactorizationTests() {
+    auto Factorize = [] () {
+        for (long long number : {24ll, 27ll, 104729ll, 123193012ll, 1000000007ll, 23567237ll,
+                                 999999999989ll * 3ll, 1000003ll * 999983ll}) {
+            auto factor = Crypto::Factorize(number);
+            BigInteger product = 1;
+            for (const auto& [divisor, power] : factor) {
+                ASSERT(PrimalityTestNative(divisor.ToLong()));
+                product *= BigInteger::pow(divisor, power);
+            }
+            ASSERT_EQUAL(product, number);
+        }
+    };
+
+    TestRunner tr;
+    RUN_TEST(tr, Factorize);
+}
+
+void ModularRootsTests() {
+    auto DiscreteLog = [] () {
+        BigInteger a = BigInteger("236487681234");
+        BigInteger b = BigInteger("1784811251");
+        BigInteger p = BigInteger("2341234243");
+        BigInteger x = Crypto::GiantStepBabyStep(a, b, p);
+        ASSERT_EQUAL(BigInteger::pow(a, x, p), b);
+    };
+
+    auto Cipolla = [] () {
+        const BigInteger p = 1000000007;
+        for (int i = 2; i <= 20; ++i) {
+            BigInteger n = (BigInteger(i) * i * 123456789) % p;
+            n = (n * 123456789) % p;
+            BigInteger root = Crypto::CipollaAlgorithm(n, p);
+            ASSERT_EQUAL((root * root) % p, n);
+        }
+    };
+
+    TestRunner tr;
+    RUN_TEST(tr, DiscreteLog);
+    RUN_TEST(tr, Cipolla);
+}
+
+void RandomNumbersTests() {
+    auto Ranges = [] () {
+        std::vector<int> hits(7);
+        for (int i = 0; i < 7000; ++i) {
+            BigInteger x = Crypto::GetRandomNumber(-3, 3);
+            ASSERT(x >= -3 && x <= 3);
+            ++hits[x.ToInt() + 3];
+        }
+        for (int count : hits) {
+            ASSERT(count > 700);
+        }
+        ASSERT_EQUAL(Crypto::GetRandomNumber(0), 0);
+        ASSERT_EQUAL(Crypto::GetRandomNumber(5, 5), 5);
+
+        const BigInteger max_value = BigInteger::pow2(200) + 1;
+        for (int i = 0; i < 100; ++i) {
+            BigInteger x = Crypto::GetRandomNumber(max_value);
+            ASSERT(x >= 0 && x <= max_value);
+        }
+        for (int bitness : {1, 2, 63, 64, 65, 1000}) {
+            ASSERT_EQUAL(Crypto::GetRandomNumberWithBitness(bitness).bit_length(), size_t(bitness));
+        }
+        ASSERT_EQUAL(Crypto::GetRandomNumberLen(30).ToString().size(), 30u);
+    };
+
+    auto Streams = [] () {
+        RandomGenerator lhs(2021), rhs(2021);
+        std::vector<RandomGenerator::Limb> limbs(21);
+        lhs.Next();
+        lhs.Fill(limbs.data(), limbs.size());
+        rhs.Next();
+        for (auto limb : limbs) {
+            ASSERT_EQUAL(limb, rhs.Next());
+        }
+        ASSERT(RandomGenerator(1).Next() != RandomGenerator(2).Next());
+
+        const BigInteger min_value = BigInteger::pow2(100), max_value = BigInteger::pow2(101);
+        auto numbers = Crypto::GetRandomNumbers(min_value, max_value, 50);
+        ASSERT_EQUAL(numbers.size(), 50u);
+        for (const auto& x : numbers) {
+            ASSERT(x >= min_value && x <= max_value);
+        }
+
+        /// Every thread has its own generator
+        RandomGenerator::Limb other = 0;
+        std::thread([&other] { other = RandomGenerator::ForThread().Next(); }).join();
+        ASSERT(other != RandomGenerator::ForThread().Next());
+    };
+
+    auto RandomPrimes = [] () {
+        auto primes = Crypto::GetRandomPrimeNumbersWithSomeBitness(40, 8);
+        ASSERT_EQUAL(primes.size(), 8u);
+        for (const auto& prime : primes) {
+            ASSERT_EQUAL(prime.bit_length(), 40u);
+            ASSERT(PrimalityTestNative(prime.ToLong()));
+        }
+    };
+
+    TestRunner tr;
+    RUN_TEST(tr, Ranges);
+    RUN_TEST(tr, Streams);
+    RUN_TEST(tr, RandomPrimes);
+}
+
 int main(int argc, char* argv[]) {
     TestRunner tr;
     RUN_TEST(tr, PrimalityTests);
+    RUN_TEST(tr, FactorizationTests);
+    RUN_TEST(tr, ModularRootsTests);
+    RUN_TEST(tr, RandomNumbersTests);
 }
\ No newline at end of file
@@ -3,11 +3,27 @@
 //
 
 #include "big_integer.h"
+#include "barrett.h"
+#include "big_integer_stats.h"
 #include "crypto_algorithms.h"
+#include "fixed_base_pow.h"
+#include "fixed_uint.h"
+#include "limb_kernels.h"
+#include "montgomery.h"
+#include "scratch_arena.h"
+#include "task_pool.h"
 
 #include "test_runner.h"
 #include "profile.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <random>
+#include <thread>
+
 namespace {
     const std::string kBase64Symbols{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
                                      "0123456789+/"};
@@ -21,6 +37,19 @@ namespace {
         static BigInteger CallKaratsubaMultiplication(const BigInteger& lhs, const BigInteger& rhs) {
             return KaratsubaMultiplication(lhs, rhs);
         }
+
+        static BigInteger CallToomCook3Multiplication(const BigInteger& lhs, const BigInteger& rhs) {
+            return ToomCook3Multiplication(lhs, rhs);
+        }
+
+        static BigInteger CallNTTMultiplication(const BigInteger& lhs, const BigInteger& rhs) {
+            return NTTMultiplication(lhs, rhs);
+        }
+
+        template <class Wins>
+        static size_t CallFindCrossover(size_t from, size_t to, Wins candidate_wins) {
+            return findCrossover(from, to, candidate_wins);
+        }
     };
 }
 
@@ -88,6 +117,60 @@ void TestConversions() {
         }
     };
 
+    auto BinaryForm = []() {
+        using ByteOrder = BigInteger::ByteOrder;
+        const uint8_t bytes[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
+        ASSERT_EQUAL(BigInteger::import_bytes(bytes, 9, ByteOrder::BigEndian).GetHex(), "10203040506070809");
+        ASSERT_EQUAL(BigInteger::import_bytes(bytes, 9, ByteOrder::LittleEndian).GetHex(), "90807060504030201");
+        ASSERT_EQUAL(BigInteger::import_bytes(bytes, 0, ByteOrder::BigEndian), 0);
+
+        std::vector<uint8_t> buffer;
+        std::vector<BigInteger> numbers{0, 1, -1, 255, -256, BigInteger::pow(2, 64), BigInteger::pow(2, 64) - 1};
+        for (int i = 1; i <= 20; ++i) {
+            numbers.push_back(Crypto::GetRandomNumberLen(30 * i) * (i % 2 == 0 ? 1 : -1));
+        }
+        for (auto order : {ByteOrder::LittleEndian, ByteOrder::BigEndian}) {
+            buffer.clear();
+            for (const auto& number : numbers) {
+                const size_t offset = buffer.size();
+                buffer.resize(offset + number.serialized_size());
+                ASSERT_EQUAL(number.write_to(buffer.data() + offset, order), number.serialized_size());
+            }
+            size_t offset = 0;
+            for (const auto& number : numbers) {
+                size_t read = 0;
+                auto result = BigInteger::read_from(buffer.data() + offset, buffer.size() - offset, read, order);
+                ASSERT(result.has_value());
+                ASSERT_EQUAL(*result, number);
+                offset += read;
+            }
+            ASSERT_EQUAL(offset, buffer.size());
+        }
+
+        size_t read = 0;
+        ASSERT(!BigInteger::read_from(buffer.data(), 3, read).has_value());
+        const BigInteger big = BigInteger::pow(3, 100);
+        buffer.assign(big.serialized_size(), 0);
+        big.write_to(buffer.data());
+        ASSERT(!BigInteger::read_from(buffer.data(), buffer.size() - 1, read).has_value());
+        ASSERT_EQUAL(big.byte_length(), 20u);
+    };
+
+    auto LongNumbers = []() {
+        BigInteger power = BigInteger::pow(10, 5000);
+        ASSERT_EQUAL(power.ToString(), "1" + std::string(5000, '0'));
+        ASSERT_EQUAL((power - 1).ToString(), std::string(5000, '9'));
+        ASSERT_EQUAL(BigInteger("-" + std::string(3000, '0') + (power + 7).ToString()), (power + 7) * -1);
+        ASSERT_EQUAL(BigInteger::pow(2, 4099).GetHex(), "8" + std::string(1024, '0'));
+        for (int i = 1; i <= 20; ++i) {
+            BigInteger number = Crypto::GetRandomNumberLen(500 * i);
+            ASSERT_EQUAL(BigInteger(number.ToString()), number);
+            ASSERT_EQUAL(BigInteger::GetFromBase2(number.GetBase2()), number);
+            ASSERT_EQUAL(BigInteger::GetFromBase64(number.GetBase64()), number);
+            ASSERT_EQUAL(BigInteger::GetFromByte(number.GetByte()), number);
+        }
+    };
+
     TestRunner tr;
     RUN_TEST(tr, Construct);
     RUN_TEST(tr, ToInt);
@@ -97,6 +180,8 @@ void TestConversions() {
     RUN_TEST(tr, FromBase64);
     RUN_TEST(tr, ToByte);
     RUN_TEST(tr, FromByte);
+    RUN_TEST(tr, BinaryForm);
+    RUN_TEST(tr, LongNumbers);
 }
 
 void TestMultiplications() {
@@ -129,6 +214,88 @@ void TestMultiplications() {
         }
     };
 
+    auto KaratsubaMultiplicationHuge = [] {
+        for (int i = 1; i <= 10; ++i) {
+            BigInteger random_a = Crypto::GetRandomNumberLen(3000);
+            BigInteger random_b = Crypto::GetRandomNumberLen(1000 + 200 * i);
+            ASSERT_EQUAL(BigIntegerMockup::CallNativeMultiplication(random_a, random_b),
+                         BigIntegerMockup::CallKaratsubaMultiplication(random_a, random_b));
+        }
+    };
+
+    auto ToomCook3Multiplication = [] {
+        for (int i = 1; i <= 10; ++i) {
+            BigInteger random_a = Crypto::GetRandomNumberLen(1000 + 300 * i);
+            BigInteger random_b = Crypto::GetRandomNumberLen(3000) * (i % 2 == 0 ? 1 : -1);
+            ASSERT_EQUAL(BigIntegerMockup::CallNativeMultiplication(random_a, random_b),
+                         BigIntegerMockup::CallToomCook3Multiplication(random_a, random_b));
+        }
+    };
+
+    auto ParallelMultiplication = [] {
+        TaskPool pool(3);
+        std::atomic<int> leaves{0};
+        std::function<void(int)> Fork = [&](int depth) {
+            if (depth == 0) {
+                ++leaves;
+                return;
+            }
+            TaskPool::Group group(pool);
+            group.Run([&, depth] { Fork(depth - 1); });
+            group.Run([&, depth] { Fork(depth - 1); });
+            Fork(depth - 1);
+        };
+        Fork(6);
+        ASSERT_EQUAL(leaves.load(), 729);
+
+        const auto saved = BigInteger::GetMultiplicationThresholds();
+        auto thresholds = saved;
+        thresholds.parallel = 64;
+        BigInteger::SetMultiplicationThresholds(thresholds);
+        TaskPool::SetGlobalWorkers(3);
+        for (int i = 1; i <= 5; ++i) {
+            BigInteger random_a = Crypto::GetRandomNumberLen(2000 * i);
+            BigInteger random_b = Crypto::GetRandomNumberLen(5000) * (i % 2 == 0 ? 1 : -1);
+            ASSERT_EQUAL(BigIntegerMockup::CallNativeMultiplication(random_a, random_b),
+                         BigIntegerMockup::CallKaratsubaMultiplication(random_a, random_b));
+            ASSERT_EQUAL(BigIntegerMockup::CallNativeMultiplication(random_a, random_b),
+                         BigIntegerMockup::CallToomCook3Multiplication(random_a, random_b));
+            ASSERT_EQUAL(BigIntegerMockup::CallNativeMultiplication(random_a, random_a),
+                         BigInteger::sqr(random_a));
+        }
+        TaskPool::SetGlobalWorkers(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        BigInteger::SetMultiplicationThresholds(saved);
+    };
+
+    auto NTTMultiplication = [] {
+        for (int i = 1; i <= 10; ++i) {
+            BigInteger random_a = Crypto::GetRandomNumberLen(100 * i);
+            BigInteger random_b = Crypto::GetRandomNumberLen(3000) * (i % 2 == 0 ? 1 : -1);
+            ASSERT_EQUAL(BigIntegerMockup::CallNativeMultiplication(random_a, random_b),
+                         BigIntegerMockup::CallNTTMultiplication(random_a, random_b));
+            ASSERT_EQUAL(BigIntegerMockup::CallNativeMultiplication(random_b, random_b),
+                         BigIntegerMockup::CallNTTMultiplication(random_b, random_b));
+        }
+        BigInteger all_ones = BigInteger::pow(2, 64 * 500) - 1;
+        ASSERT_EQUAL(BigIntegerMockup::CallNTTMultiplication(all_ones, all_ones),
+                     BigInteger::pow(2, 64 * 1000) - BigInteger::pow(2, 64 * 500 + 1) + 1);
+    };
+
+    auto ScratchArenaSteadyState = [] {
+        BigInteger random_a = Crypto::GetRandomNumberLen(5000);
+        BigInteger random_b = Crypto::GetRandomNumberLen(3000);
+        BigInteger expected = random_a * random_b;
+
+        ScratchArena& arena = ScratchArena::local();
+        arena.resetStats();
+        for (int i = 0; i < 10; ++i) {
+            ASSERT_EQUAL(random_a * random_b, expected);
+            ASSERT_EQUAL((expected / random_b), random_a);
+        }
+        ASSERT(arena.stats().allocations > 0);
+        ASSERT_EQUAL(arena.stats().heap_allocations, 0u);
+    };
+
     auto CompareMultiplicationsTime = [] {
         for (int i = 1; i <= 1; ++i) {
             BigInteger random_a = Crypto::GetRandomNumberLen(10000);
@@ -143,18 +310,595 @@ void TestMultiplications() {
                 BigIntegerMockup::CallKaratsubaMultiplication(random_a, random_b);
             }
         }
+
+        /// Sizes 8, 10, 12, 15, 18: a win has to hold at two measured sizes in a row
+        constexpr size_t kNever = std::numeric_limits<size_t>::max();
+        auto WinsAt = [](std::vector<size_t> sizes) {
+            return [sizes](size_t size) {
+                return std::find(sizes.begin(), sizes.end(), size) != sizes.end();
+            };
+        };
+        ASSERT_EQUAL(BigIntegerMockup::CallFindCrossover(8, 20, WinsAt({18})), kNever);
+        ASSERT_EQUAL(BigIntegerMockup::CallFindCrossover(8, 20, WinsAt({10, 15})), kNever);
+        ASSERT_EQUAL(BigIntegerMockup::CallFindCrossover(8, 20, WinsAt({15, 18})), 15u);
+        ASSERT_EQUAL(BigIntegerMockup::CallFindCrossover(8, 20, WinsAt({8, 10, 15})), 8u);
+
+        /// Tuning measures with forking off and keeps the parallel cutoff of the caller
+        const auto saved = BigInteger::GetMultiplicationThresholds();
+        auto custom = saved;
+        custom.parallel = 100;
+        BigInteger::SetMultiplicationThresholds(custom);
+        auto thresholds = BigInteger::TuneMultiplicationThresholds();
+        ASSERT_EQUAL(thresholds.parallel, custom.parallel);
+        ASSERT_EQUAL(BigInteger::GetMultiplicationThresholds().parallel, custom.parallel);
+        BigInteger::SetMultiplicationThresholds(saved);
+        std::cout << "Tuned thresholds: karatsuba " << thresholds.karatsuba
+                  << ", toom3 " << thresholds.toom3 << ", ntt " << thresholds.ntt << std::endl;
+    };
+
+    auto LimbKernelsMatchPortable = [] {
+        const auto& portable = LimbKernels::Portable();
+        const auto& native = LimbKernels::Native();
+        std::mt19937_64 random(42);
+        auto limb = [&random] {
+            return (random() % 4 == 0 ? ~uint64_t(0) : random());
+        };
+        for (size_t n = 0; n <= 40; ++n) {
+            std::vector<uint64_t> a(n), b(n), base(n);
+            for (size_t i = 0; i < n; ++i) {
+                a[i] = limb();
+                b[i] = limb();
+                base[i] = limb();
+            }
+            const uint64_t word = limb();
+            auto expected = base;
+            auto result = base;
+            ASSERT_EQUAL(portable.add(expected.data(), a.data(), b.data(), n),
+                         native.add(result.data(), a.data(), b.data(), n));
+            ASSERT_EQUAL(expected, result);
+            ASSERT_EQUAL(portable.sub(expected.data(), a.data(), b.data(), n),
+                         native.sub(result.data(), a.data(), b.data(), n));
+            ASSERT_EQUAL(expected, result);
+            ASSERT_EQUAL(portable.addmul(expected.data(), a.data(), n, word),
+                         native.addmul(result.data(), a.data(), n, word));
+            ASSERT_EQUAL(expected, result);
+            ASSERT_EQUAL(portable.submul(expected.data(), a.data(), n, word),
+                         native.submul(result.data(), a.data(), n, word));
+            ASSERT_EQUAL(expected, result);
+        }
+    };
+
+    auto CompareLimbKernelsTime = [] {
+        std::mt19937_64 random(42);
+        for (size_t n : {4, 16, 64, 256, 1024}) {
+            std::vector<uint64_t> a(n), b(n), result(n);
+            for (size_t i = 0; i < n; ++i) {
+                a[i] = random();
+                b[i] = random();
+            }
+            const size_t repeats = (1 << 22) / n;
+            for (const auto* kernels : {&LimbKernels::Portable(), &LimbKernels::Native()}) {
+                auto measure = [&](auto kernel) {
+                    auto start = std::chrono::steady_clock::now();
+                    for (size_t i = 0; i < repeats; ++i) {
+                        kernel();
+                    }
+                    std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+                    return time.count() / (repeats * n);
+                };
+                const double add = measure([&] { return kernels->add(result.data(), a.data(), b.data(), n); });
+                const double sub = measure([&] { return kernels->sub(result.data(), a.data(), b.data(), n); });
+                const double addmul = measure([&] { return kernels->addmul(result.data(), a.data(), n, b[0]); });
+                const double submul = measure([&] { return kernels->submul(result.data(), a.data(), n, b[0]); });
+                std::cout << n << " limbs, " << kernels->name << ": add " << add << ", sub " << sub
+                          << ", addmul " << addmul << ", submul " << submul << " ns per limb" << std::endl;
+            }
+        }
     };
 
     TestRunner tr;
     RUN_TEST(tr, NativeMultiplication);
     RUN_TEST(tr, KaratsubaMultiplicationSmall);
     RUN_TEST(tr, KaratsubaMultiplicationBig);
+    RUN_TEST(tr, KaratsubaMultiplicationHuge);
+    RUN_TEST(tr, ToomCook3Multiplication);
+    RUN_TEST(tr, ParallelMultiplication);
+    RUN_TEST(tr, NTTMultiplication);
+    RUN_TEST(tr, ScratchArenaSteadyState);
+    RUN_TEST(tr, LimbKernelsMatchPortable);
 
     RUN_TEST(tr, CompareMultiplicationsTime);
+    RUN_TEST(tr, CompareLimbKernelsTime);
+}
+
+void TestArithmetic() {
+    auto LimbBoundaries = [] {
+        BigInteger base = BigInteger::pow(2, 64);
+        ASSERT_EQUAL("18446744073709551616", base.ToString());
+        ASSERT_EQUAL("18446744073709551615", (base - 1).ToString());
+        ASSERT_EQUAL("340282366920938463463374607431768211456", (base * base).ToString());
+        ASSERT_EQUAL(base, (base * base) / base);
+        ASSERT_EQUAL(BigInteger(0), (base * base) % base);
+        ASSERT_EQUAL(BigInteger(-1), BigInteger(0) - 1);
+        ASSERT_EQUAL("-9223372036854775808", BigInteger(-9223372036854775807ll - 1).ToString());
+    };
+
+    auto DivisionIdentity = [] {
+        for (int i = 1; i <= 100; ++i) {
+            BigInteger a = Crypto::GetRandomNumberLen(200);
+            BigInteger b = Crypto::GetRandomNumberLen(1 + i);
+            if (i % 2 == 0) {
+                a *= -1;
+            }
+            BigInteger q = a / b;
+            BigInteger r = a % b;
+            ASSERT(BigInteger::abs(r) < b);
+            ASSERT_EQUAL(a, q * b + r);
+        }
+    };
+
+    auto DivMod = [] {
+        BigInteger max_limb("18446744073709551615");
+        BigInteger lhs = BigInteger::pow(max_limb, 7) + BigInteger::pow(2, 300);
+        BigInteger rhs = BigInteger::pow(max_limb, 3) - 1;
+        BigInteger quotient, remainder;
+        BigInteger::divmod(lhs, rhs, quotient, remainder);
+        ASSERT_EQUAL(quotient, lhs / rhs);
+        ASSERT_EQUAL(remainder, lhs % rhs);
+        ASSERT_EQUAL(lhs, quotient * rhs + remainder);
+
+        BigInteger a = lhs, b = rhs;
+        BigInteger::divmod(a, b, a, b);
+        ASSERT_EQUAL(a, quotient);
+        ASSERT_EQUAL(b, remainder);
+
+        ASSERT_EQUAL(BigInteger::mod(-7, 3), 2);
+        ASSERT_EQUAL(BigInteger::mod(7, -3), -2);
+        ASSERT_EQUAL(BigInteger::mod(-6, 3), 0);
+        ASSERT_EQUAL(BigInteger(-7) % 3, -1);
+        ASSERT_EQUAL(BigInteger(-7) / 3, -2);
+    };
+
+    auto ScalarOperations = [] {
+        const long long kMin = -9223372036854775807ll - 1;
+        for (long long scalar : {3ll, -7ll, 256ll, 1000000007ll, -4294967296ll, kMin}) {
+            for (int i = 1; i <= 20; ++i) {
+                BigInteger a = Crypto::GetRandomNumberLen(10 * i);
+                if (i % 3 == 0) {
+                    a *= -1;
+                }
+                const BigInteger b(scalar);
+                ASSERT_EQUAL(a * b, a * scalar);
+                ASSERT_EQUAL(a / b, a / scalar);
+                ASSERT_EQUAL(a % b, a % scalar);
+                ASSERT_EQUAL(a + b, a + scalar);
+                ASSERT_EQUAL(a - b, a - scalar);
+
+                BigInteger quotient;
+                long long remainder = BigInteger::divmod_small(a, scalar, quotient);
+                ASSERT_EQUAL(a / b, quotient);
+                ASSERT_EQUAL(a % b, remainder);
+
+                /// The remainder is written into the storage of the dividend
+                ASSERT_EQUAL(BigInteger(a) % scalar, a % b);
+                BigInteger c = a;
+                const BigInteger::Limb* storage = c.data().data();
+                c %= scalar;
+                ASSERT_EQUAL(c, a % b);
+                ASSERT(c.data().data() == storage);
+            }
+        }
+        ASSERT(BigInteger(kMin) == kMin);
+        ASSERT(BigInteger(0) == 0);
+        ASSERT(BigInteger(-5) != 5);
+        ASSERT_EQUAL(BigInteger(3) - 5, -2);
+        ASSERT_EQUAL(BigInteger(-3) + 5, 2);
+    };
+
+    auto DecimalLength = [] {
+        ASSERT_EQUAL(1u, BigInteger(0).getLength());
+        ASSERT_EQUAL(20u, BigInteger::pow(10, 19).getLength());
+        ASSERT_EQUAL(3, BigInteger("3123").getDigitAt(1));
+        ASSERT_EQUAL(2, BigInteger("-3123").getDigitAt(3));
+        ASSERT_EQUAL(0, BigInteger(0).getDigitAt(1));
+        ASSERT_EQUAL(1, BigInteger("18446744073709551615").getDigitAt(1));
+        ASSERT_EQUAL(5, BigInteger("18446744073709551615").getDigitAt(20));
+        ASSERT_EQUAL(6, BigInteger("18446744073709551616").getDigitAt(20));
+    };
+
+    auto PowerWithEvenModule = [] {
+        unsigned long long expected = 1;
+        for (int i = 1; i <= 1000; ++i) {
+            expected *= 3;
+        }
+        BigInteger mod = BigInteger::pow(2, 64);
+        ASSERT_EQUAL(std::to_string(expected), BigInteger::pow(3, 1000, mod).ToString());
+        ASSERT_EQUAL(BigInteger::pow(3, 1000) % mod, BigInteger::pow(3, 1000, mod));
+        ASSERT_EQUAL(BigInteger::pow(7, 0, 1), 0);
+    };
+
+    auto Squaring = [] {
+        for (int i = 1; i <= 30; ++i) {
+            BigInteger random_a = Crypto::GetRandomNumberLen(50 * i * i) * (i % 2 == 0 ? 1 : -1);
+            ASSERT_EQUAL(BigInteger::sqr(random_a), BigIntegerMockup::CallNativeMultiplication(random_a, random_a));
+        }
+        BigInteger all_ones = BigInteger::pow(2, 64 * 40) - 1;
+        ASSERT_EQUAL(BigInteger::sqr(all_ones), BigInteger::pow(2, 64 * 80) - BigInteger::pow(2, 64 * 40 + 1) + 1);
+
+        BigInteger n = Crypto::GetRandomNumberLen(3000) * 2 + 1;
+        MontgomeryContext context(n);
+        for (int i = 1; i <= 5; ++i) {
+            BigInteger a = Crypto::GetRandomNumber(n - 1);
+            ASSERT_EQUAL(context.FromMontgomery(context.sqr(context.ToMontgomery(a))), BigInteger::sqr(a) % n);
+        }
+    };
+
+    auto Gcd = [] {
+        ASSERT_EQUAL(BigInteger::gcd(0, 0), 0);
+        ASSERT_EQUAL(BigInteger::gcd(BigInteger::pow(2, 300), BigInteger::pow(6, 100)), BigInteger::pow(2, 100));
+        ASSERT_EQUAL(BigInteger::lcm(BigInteger::pow(2, 300), BigInteger::pow(6, 100)),
+                     BigInteger::pow(2, 300) * BigInteger::pow(3, 100));
+
+        BigInteger fib_prev = 1, fib = 1;
+        for (int i = 0; i < 2000; ++i) {
+            fib_prev += fib;
+            std::swap(fib_prev, fib);
+        }
+        ASSERT_EQUAL(BigInteger::gcd(fib, fib_prev), 1);
+
+        for (int i = 1; i <= 30; ++i) {
+            BigInteger g = Crypto::GetRandomNumberLen(5 * i) + 1;
+            BigInteger a = Crypto::GetRandomNumberLen(30 * i) * g;
+            BigInteger b = Crypto::GetRandomNumberLen(20 * i) * g * (i % 2 == 0 ? 1 : -1);
+            BigInteger d = BigInteger::gcd(a, b);
+            ASSERT_EQUAL(a % d, 0);
+            ASSERT_EQUAL(b % d, 0);
+            ASSERT_EQUAL(d % g, 0);
+            ASSERT_EQUAL(BigInteger::gcd(a / d, b / d), 1);
+        }
+    };
+
+    auto ModularInverse = [] {
+        for (int i = 1; i <= 30; ++i) {
+            BigInteger a = Crypto::GetRandomNumberLen(20 * i) * (i % 3 == 0 ? -1 : 1);
+            BigInteger b = Crypto::GetRandomNumberLen(15 * i) + 1;
+            BigInteger x, y;
+            BigInteger g = BigInteger::ext_gcd(a, b, x, y);
+            ASSERT_EQUAL(g, BigInteger::gcd(a, b));
+            ASSERT_EQUAL(a * x + b * y, g);
+
+            auto inverse = BigInteger::inverse_mod(a, b);
+            ASSERT_EQUAL(inverse.has_value(), g == 1);
+            if (inverse) {
+                ASSERT_EQUAL(BigInteger::mod(a * *inverse, b), 1);
+            }
+        }
+        ASSERT_EQUAL(BigInteger::inverse_mod(6, 9).has_value(), false);
+
+        BigInteger p = Crypto::GetClosestPrimeNumber(Crypto::GetRandomNumberLen(60));
+        std::vector<BigInteger> numbers;
+        for (int i = 1; i <= 20; ++i) {
+            numbers.push_back(Crypto::GetRandomNumber(1, p - 1) * (i % 2 == 0 ? 1 : -1));
+        }
+        auto inverses = BigInteger::batch_inverse_mod(numbers, p);
+        ASSERT(inverses.has_value());
+        for (size_t i = 0; i < numbers.size(); ++i) {
+            ASSERT_EQUAL((*inverses)[i], *BigInteger::inverse_mod(numbers[i], p));
+        }
+        numbers.push_back(p * 2);
+        ASSERT_EQUAL(BigInteger::batch_inverse_mod(numbers, p).has_value(), false);
+    };
+
+    auto SquareRoot = [] {
+        for (int i = 0; i <= 100; ++i) {
+            ASSERT_EQUAL(BigInteger::isqrt(i * i), i);
+            ASSERT_EQUAL(BigInteger::is_perfect_square(i * i), true);
+            ASSERT_EQUAL(BigInteger::is_perfect_square(i * i + 2), false);
+        }
+        ASSERT_EQUAL(BigInteger::isqrt(BigInteger::pow(2, 128) - 1), BigInteger::pow(2, 64) - 1);
+        for (int i = 1; i <= 30; ++i) {
+            BigInteger root = Crypto::GetRandomNumberLen(30 * i);
+            BigInteger square = BigInteger::sqr(root);
+            ASSERT_EQUAL(BigInteger::isqrt(square), root);
+            ASSERT_EQUAL(BigInteger::isqrt(square - 1), root - 1);
+            ASSERT_EQUAL(BigInteger::isqrt(square + root * 2), root);
+            ASSERT_EQUAL(BigInteger::is_perfect_square(square), true);
+            ASSERT_EQUAL(BigInteger::is_perfect_square(square + 1), false);
+        }
+    };
+
+    auto FixedWidth = [] {
+        using U256 = FixedUInt<256>;
+        constexpr U256 prime = U256::FromHex("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2F");
+        static_assert(U256::mulmod(prime - U256(1), prime - U256(1), prime) == U256(1));
+        static_assert(U256::addmod(prime - U256(1), U256(2), prime) == U256(1));
+        static_assert((U256(0) - U256(1)).bit_length() == 256);
+
+        const BigInteger modulus = prime.ToBigInteger();
+        ASSERT_EQUAL(modulus, BigInteger::pow(2, 256) - BigInteger::pow(2, 32) - 977);
+        for (int i = 1; i <= 50; ++i) {
+            BigInteger a = Crypto::GetRandomNumber(modulus - 1);
+            BigInteger b = Crypto::GetRandomNumber(modulus - 1);
+            U256 x = U256::FromBigInteger(a);
+            U256 y = U256::FromBigInteger(b);
+            ASSERT_EQUAL(x.ToBigInteger(), a);
+            ASSERT_EQUAL(U256::addmod(x, y, prime).ToBigInteger(), (a + b) % modulus);
+            ASSERT_EQUAL(U256::submod(x, y, prime).ToBigInteger(), BigInteger::mod(a - b, modulus));
+            ASSERT_EQUAL(U256::mulmod(x, y, prime).ToBigInteger(), (a * b) % modulus);
+            ASSERT_EQUAL(x.mul_full(y).ToBigInteger(), a * b);
+            ASSERT_EQUAL(U256::mod(x, U256(1000003)).ToBigInteger(), a % 1000003);
+            ASSERT_EQUAL(BigInteger::GetFromBase2(x.GetBase2()), a);
+        }
+    };
+
+    auto InlineStorage = [] {
+        BigInteger small("123456789012345678901234567890");
+        ASSERT_EQUAL(small.data().is_inline(), true);
+        ASSERT_EQUAL((small * small).data().is_inline(), true);
+
+        BigInteger big = BigInteger::pow(small, 10);
+        ASSERT_EQUAL(big.data().is_inline(), false);
+        BigInteger moved = std::move(big);
+        ASSERT_EQUAL(moved / BigInteger::pow(small, 9), small);
+        ASSERT_EQUAL((moved % small).data().is_inline(), true);
+
+        BigInteger::Limbs limbs{1, 2, 3};
+        for (BigInteger::Limb i = 0; i < 100; ++i) {
+            limbs.push_back(i);
+        }
+        BigInteger::Limbs copy = limbs;
+        ASSERT_EQUAL(copy == limbs, true);
+        copy.erase(copy.begin(), copy.begin() + 3);
+        ASSERT_EQUAL(copy.size(), 100u);
+        ASSERT_EQUAL(copy.back(), 99u);
+    };
+
+    auto TemporaryOperands = [] {
+        for (int i = 1; i <= 50; ++i) {
+            BigInteger a = Crypto::GetRandomNumberLen(3 * i) * (i % 2 == 0 ? 1 : -1);
+            BigInteger b = (Crypto::GetRandomNumberLen(i % 7 * 10 + 1) + 1) * (i % 3 == 0 ? 1 : -1);
+            const BigInteger sum = a + b, diff = a - b, quotient = a / b, remainder = a % b;
+            ASSERT_EQUAL(BigInteger(a) + b, sum);
+            ASSERT_EQUAL(a + BigInteger(b), sum);
+            ASSERT_EQUAL(BigInteger(a) + BigInteger(b), sum);
+            ASSERT_EQUAL(BigInteger(a) - b, diff);
+            ASSERT_EQUAL(a - BigInteger(b), diff);
+            ASSERT_EQUAL(BigInteger(a) - BigInteger(b), diff);
+            ASSERT_EQUAL(BigInteger(a) / b, quotient);
+            ASSERT_EQUAL(BigInteger(a) % b, remainder);
+            ASSERT_EQUAL(quotient * b + remainder, a);
+            ASSERT_EQUAL(BigInteger(a) * 7 - 5, a * 7 - 5);
+            ASSERT_EQUAL(BigInteger(a) / 7 % 5, (a / 7) % 5);
+            ASSERT_EQUAL(BigInteger::mod(BigInteger(a), b), BigInteger::mod(a, b));
+
+            BigInteger c = a;
+            c += c;
+            ASSERT_EQUAL(c, a * 2);
+            c -= c;
+            ASSERT_EQUAL(c, 0);
+            c = a;
+            c %= c;
+            ASSERT_EQUAL(c, 0);
+            c = a;
+            c /= c;
+            ASSERT_EQUAL(c, 1);
+        }
+
+        /// The remainder is written into the storage of the product
+        BigInteger modulus = Crypto::GetRandomNumberLen(300);
+        BigInteger product = Crypto::GetRandomNumberLen(600) * Crypto::GetRandomNumberLen(600);
+        const BigInteger::Limb* storage = product.data().data();
+        BigInteger remainder = std::move(product) % modulus;
+        ASSERT(remainder.data().data() == storage);
+        BigInteger sum = std::move(remainder) + modulus;
+        ASSERT(sum.data().data() == storage);
+    };
+
+    auto BitOperations = [] {
+        const std::vector<long long> small{0, 1, -1, 5, -5, 12, -12, 1ll << 62, -(1ll << 62) + 3};
+        for (long long x : small) {
+            for (long long y : small) {
+                ASSERT_EQUAL(BigInteger(x) & y, x & y);
+                ASSERT_EQUAL(BigInteger(x) | y, x | y);
+                ASSERT_EQUAL(BigInteger(x) ^ y, x ^ y);
+            }
+            for (size_t shift : {0, 1, 3, 63, 64, 100}) {
+                ASSERT_EQUAL(BigInteger(x) >> shift, shift < 64 ? x >> shift : (x < 0 ? -1 : 0));
+                ASSERT_EQUAL(BigInteger(x).test_bit(shift), shift < 64 ? ((x >> shift) & 1) == 1 : x < 0);
+            }
+        }
+        ASSERT_EQUAL(BigInteger(0).bit_length(), 0u);
+        ASSERT_EQUAL(BigInteger(-255).bit_length(), 8u);
+        ASSERT_EQUAL(BigInteger(0).count_trailing_zeros(), 0u);
+        ASSERT_EQUAL(BigInteger(-96).count_trailing_zeros(), 5u);
+        ASSERT_EQUAL(BigInteger::pow2(200), BigInteger::pow(2, 200));
+        ASSERT_EQUAL(BigInteger::pow2(200).count_trailing_zeros(), 200u);
+        ASSERT_EQUAL(BigInteger::pow2(200).bit_length(), 201u);
+
+        for (int i = 1; i <= 50; ++i) {
+            BigInteger a = Crypto::GetRandomNumberLen(7 * i) * (i % 2 == 0 ? 1 : -1);
+            BigInteger b = Crypto::GetRandomNumberLen(11 * (51 - i)) * (i % 3 == 0 ? 1 : -1);
+            const size_t shift = 13 * i;
+            const BigInteger power = BigInteger::pow2(shift);
+            ASSERT_EQUAL(a << shift, a * power);
+            ASSERT_EQUAL(BigInteger(a) << shift, a * power);
+            ASSERT_EQUAL(a >> shift, a.IsPositive() ? a / power : (a + 1) / power - 1);
+            ASSERT_EQUAL((a << shift) >> shift, a);
+            ASSERT_EQUAL(a & (power - 1), BigInteger::mod(a, power));
+            ASSERT_EQUAL(a ^ -1, BigInteger(-1) - a);
+            ASSERT_EQUAL(a ^ b, (a | b) - (a & b));
+            ASSERT_EQUAL(a + b, (a ^ b) + (a & b) * 2);
+            ASSERT_EQUAL(a.test_bit(shift), ((a >> shift) & 1) == 1);
+            ASSERT_EQUAL(a.bit_length(), BigInteger::abs(a).GetBase2().size());
+
+            BigInteger c = a;
+            c &= c;
+            ASSERT_EQUAL(c, a);
+            c ^= c;
+            ASSERT_EQUAL(c, 0);
+            c = a;
+            c |= b;
+            ASSERT_EQUAL(c, a | b);
+            c >>= shift;
+            c <<= 1;
+            ASSERT_EQUAL(c, ((a | b) >> shift) * 2);
+        }
+    };
+
+    auto OperationCounters = [] {
+        using BigIntegerStats::Operation;
+        BigIntegerStats::Reset();
+        BigInteger a = Crypto::GetRandomNumberLen(2000), b = Crypto::GetRandomNumberLen(2000);
+        BigInteger product = a * b;
+        std::thread([&] { BigInteger::gcd(a, b); }).join();
+        ASSERT_EQUAL(product / a, b);
+
+        const auto snapshot = BigIntegerStats::GetSnapshot();
+        if (!BigIntegerStats::IsEnabled()) {
+            ASSERT_EQUAL(snapshot[Operation::Multiply].calls, 0u);
+            ASSERT_EQUAL(snapshot.allocations, 0u);
+            return;
+        }
+        ASSERT(snapshot[Operation::Multiply].calls >= 1);
+        ASSERT(snapshot[Operation::Multiply].limbs >= a.data().size() + b.data().size());
+        ASSERT(snapshot[Operation::Karatsuba].calls >= 1);
+        ASSERT(snapshot[Operation::Divide].calls >= 1);
+        /// Counters of a finished thread stay in the snapshot
+        ASSERT(snapshot[Operation::Gcd].calls >= 1);
+        ASSERT(snapshot.allocations >= 1);
+        ASSERT(snapshot.allocated_bytes >= product.data().size() * sizeof(BigInteger::Limb));
+
+        BigIntegerStats::Reset();
+        ASSERT_EQUAL(BigIntegerStats::GetSnapshot()[Operation::Multiply].calls, 0u);
+        ASSERT_EQUAL(std::string(BigIntegerStats::GetName(Operation::ToomCook3)), "toom_cook3");
+    };
+
+    TestRunner tr;
+    RUN_TEST(tr, LimbBoundaries);
+    RUN_TEST(tr, DivisionIdentity);
+    RUN_TEST(tr, DivMod);
+    RUN_TEST(tr, ScalarOperations);
+    RUN_TEST(tr, DecimalLength);
+    RUN_TEST(tr, PowerWithEvenModule);
+    RUN_TEST(tr, Squaring);
+    RUN_TEST(tr, Gcd);
+    RUN_TEST(tr, ModularInverse);
+    RUN_TEST(tr, SquareRoot);
+    RUN_TEST(tr, FixedWidth);
+    RUN_TEST(tr, InlineStorage);
+    RUN_TEST(tr, TemporaryOperands);
+    RUN_TEST(tr, BitOperations);
+    RUN_TEST(tr, OperationCounters);
+}
+
+void TestMontgomery() {
+    auto Multiplication = [] {
+        for (int i = 1; i <= 100; ++i) {
+            BigInteger n = Crypto::GetRandomNumberLen(10 + i);
+            if (n.IsEven()) {
+                n += 1;
+            }
+            MontgomeryContext context(n);
+            BigInteger a = Crypto::GetRandomNumber(n - 1);
+            BigInteger b = Crypto::GetRandomNumber(n - 1);
+            BigInteger product = context.mul(context.ToMontgomery(a), context.ToMontgomery(b));
+            ASSERT_EQUAL((a * b) % n, context.FromMontgomery(product));
+            ASSERT_EQUAL((a * a) % n, context.FromMontgomery(context.sqr(context.ToMontgomery(a))));
+        }
+    };
+
+    auto Power = [] {
+        MontgomeryContext context(1000000007);
+        long long expected = 1;
+        for (int i = 0; i <= 100; ++i) {
+            ASSERT_EQUAL(context.pow(123456789, i), expected);
+            ASSERT_EQUAL(context.pow_montgomery(123456789, i), context.ToMontgomery(expected));
+            expected = (expected * 123456789) % 1000000007;
+        }
+    };
+
+    auto FermatLittleTheorem = [] {
+        for (int i = 1; i <= 5; ++i) {
+            BigInteger p = Crypto::GetClosestPrimeNumber(Crypto::GetRandomNumberLen(50 * i));
+            BigInteger a = Crypto::GetRandomNumber(2, p - 1);
+            ASSERT_EQUAL(MontgomeryContext(p).pow(a, p - 1), 1);
+            ASSERT_EQUAL(BigInteger::pow(a, p, p), a);
+        }
+    };
+
+    auto MultiPower = [] {
+        for (int i = 1; i <= 20; ++i) {
+            BigInteger n = Crypto::GetRandomNumberLen(20 * i);
+            if (i % 2 == 0) {
+                n += n.IsOdd() ? 1 : 0;
+            }
+            std::vector<BigInteger> bases, powers;
+            BigInteger expected = BigInteger(1) % n;
+            for (int k = 0; k < i % 5 + 1; ++k) {
+                bases.push_back(Crypto::GetRandomNumberLen(30 * i) * (k % 2 == 0 ? 1 : -1));
+                powers.push_back(k == 1 ? BigInteger(0) : Crypto::GetRandomNumberLen(10 * i * (k + 1)));
+                expected = (expected * BigInteger::pow(bases.back(), powers.back(), n)) % n;
+            }
+            ASSERT_EQUAL(BigInteger::multi_pow(bases, powers, n), expected);
+        }
+        ASSERT_EQUAL(BigInteger::multi_pow({}, {}, 1000000007), 1);
+        ASSERT_EQUAL(BigInteger::multi_pow({2, 3}, {10, 5}, 1000000007), 1024 * 243);
+        ASSERT_EQUAL(BigInteger::multi_pow({2, 3}, {10, 5}, 1 << 20), 1024 * 243);
+        ASSERT_EQUAL(BigInteger::multi_pow({5}, {3}, 1), 0);
+    };
+
+    auto FixedBasePower = [] {
+        for (int i = 1; i <= 10; ++i) {
+            BigInteger p = Crypto::GetRandomNumberLen(30 * i);
+            BigInteger g = Crypto::GetRandomNumber(2, p - 1);
+            FixedBasePow fixed(g, p, 0, i % 6 + 1);
+            for (int j = 0; j < 5; ++j) {
+                BigInteger power = Crypto::GetRandomNumberLen(10 * i * (j + 1));
+                ASSERT_EQUAL(fixed.pow(power), BigInteger::pow(g, power, p));
+            }
+            ASSERT_EQUAL(fixed.pow(0), 1);
+        }
+        ASSERT_EQUAL(FixedBasePow(3, 1 << 20).pow(1000), BigInteger::pow(3, 1000, 1 << 20));
+        ASSERT_EQUAL(FixedBasePow(3, 1).pow(5), 0);
+
+        BigInteger p = Crypto::GetClosestPrimeNumber(Crypto::GetRandomNumberLen(100));
+        auto table = FixedBasePow::Get(5, p);
+        ASSERT(table == FixedBasePow::Get(5, p));
+        ASSERT_EQUAL(table->pow(p - 1), 1);
+    };
+
+    TestRunner tr;
+    RUN_TEST(tr, Multiplication);
+    RUN_TEST(tr, Power);
+    RUN_TEST(tr, FermatLittleTheorem);
+    RUN_TEST(tr, MultiPower);
+    RUN_TEST(tr, FixedBasePower);
+}
+
+void TestBarrett() {
+    auto Reduction = [] {
+        for (int i = 1; i <= 100; ++i) {
+            BigInteger n = Crypto::GetRandomNumberLen(i);
+            BarrettReducer reducer(n);
+            BigInteger a = Crypto::GetRandomNumberLen(2 * i);
+            BigInteger b = Crypto::GetRandomNumber(n - 1);
+            ASSERT_EQUAL(a % n, reducer.reduce(a));
+            ASSERT_EQUAL(BigInteger::mod(a * -1, n), reducer.reduce(a * -1));
+            ASSERT_EQUAL((a * a * a) % n, reducer.reduce(a * a * a));
+            ASSERT_EQUAL((b * b) % n, reducer.sqrmod(b));
+            ASSERT_EQUAL((a * b) % n, reducer.mulmod(a % n, b));
+        }
+    };
+
+    TestRunner tr;
+    RUN_TEST(tr, Reduction);
 }
 
 int main(int argc, char* argv[]) {
     TestRunner tr;
     RUN_TEST(tr, TestConversions);
     RUN_TEST(tr, TestMultiplications);
+    RUN_TEST(tr, TestArithmetic);
+    RUN_TEST(tr, TestMontgomery);
+    RUN_TEST(tr, TestBarrett);
 }
\ No newline at end of file